@@ -0,0 +1,89 @@
+/**
+ * @file AttackTables.hpp
+ * @brief Attack tables of the leaping pieces, empty board slider rays and the squares between and along two squares,
+ * all built at compile time.
+ */
+
+#ifndef ATTACKTABLES_HPP
+#define ATTACKTABLES_HPP
+
+#include "Constants.hpp"
+
+/**
+ * @brief Attack tables shared by every Generator in the process. Computed by the compiler and stored in read-only data,
+ * so any number of threads may read them without locking and no instance pays to build them.
+*/
+struct AttackTables {
+    U64 king[NSQUARES]; ///< All possible attacks of a king at each position on the board.
+    U64 knight[NSQUARES]; ///< All possible attacks of a knight at each position on the board.
+    U64 pawn[2][NSQUARES]; ///< Diagonal attacks of a pawn of each colour (indexed by Color) at each position on the board.
+    U64 rook[NSQUARES]; ///< Rook attacks on an empty board, the rank and file through each square excluding it.
+    U64 bishop[NSQUARES]; ///< Bishop attacks on an empty board, both diagonals through each square excluding it.
+    U64 between[NSQUARES][NSQUARES]; ///< Squares strictly between two squares on a shared rank, file or diagonal, zero otherwise.
+    U64 line[NSQUARES][NSQUARES]; ///< The whole rank, file or diagonal through two squares edge to edge, zero if they share none.
+};
+
+constexpr int RAY_STEPS[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}}; ///< (rank, file) steps of the four straight then four diagonal rays.
+
+/**
+ * @brief Get the squares reached from a square by repeatedly taking one step, stopping at the board edge.
+ * @param square The LSB of the starting square, not included.
+ * @param rankStep Ranks moved per step.
+ * @param fileStep Files moved per step.
+ * @param maxSteps Stop after this many steps, 1 for the leaping pieces.
+ * @return Bitboard of the squares reached.
+*/
+constexpr U64 GenerateRay(const int square, const int rankStep, const int fileStep, const int maxSteps) {
+    U64 ray = 0;
+    int rank = square / BITS_PER_FILE + rankStep;
+    int file = square % BITS_PER_FILE + fileStep;
+    for(int iStep = 0; iStep < maxSteps && rank >= 0 && rank < 8 && file >= 0 && file < 8; ++iStep) {
+        ray |= 1ULL << (rank * BITS_PER_FILE + file);
+        rank += rankStep;
+        file += fileStep;
+    }
+    return ray;
+}
+
+/**
+ * @brief Generate every attack table.
+ * @return The filled tables.
+*/
+constexpr AttackTables GenerateAttackTables() {
+    constexpr int knightSteps[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+    AttackTables tables{};
+    for(int square = 0; square < NSQUARES; ++square) {
+        for(int iDir = 0; iDir < 8; ++iDir) {
+            const int rankStep = RAY_STEPS[iDir][0];
+            const int fileStep = RAY_STEPS[iDir][1];
+            tables.king[square] |= GenerateRay(square, rankStep, fileStep, 1);
+            tables.knight[square] |= GenerateRay(square, knightSteps[iDir][0], knightSteps[iDir][1], 1);
+            if(iDir < 4) {
+                tables.rook[square] |= GenerateRay(square, rankStep, fileStep, 8);
+            } else {
+                tables.bishop[square] |= GenerateRay(square, rankStep, fileStep, 8);
+            }
+
+            // Walk the ray, every square on it shares this line with the start and is separated from it by the walk so far
+            const U64 line = (1ULL << square) | GenerateRay(square, rankStep, fileStep, 8) | GenerateRay(square, -rankStep, -fileStep, 8);
+            U64 between = 0;
+            for(int iStep = 1; iStep < 8; ++iStep) {
+                const U64 target = GenerateRay(square, rankStep * iStep, fileStep * iStep, 1);
+                if(!target)
+                    break;
+                const int targetLSB = __builtin_ctzll(target);
+                tables.between[square][targetLSB] = between;
+                tables.line[square][targetLSB] = line;
+                between |= target;
+            }
+        }
+        // Only valid when occupied by enemy piece as these are taking moves
+        tables.pawn[(int)Color::White][square] = GenerateRay(square, 1, 1, 1) | GenerateRay(square, 1, -1, 1);
+        tables.pawn[(int)Color::Black][square] = GenerateRay(square, -1, 1, 1) | GenerateRay(square, -1, -1, 1);
+    }
+    return tables;
+}
+
+inline constexpr AttackTables ATTACK_TABLES = GenerateAttackTables(); ///< Attack tables shared by every Generator, built at compile time.
+
+#endif
@@ -15,10 +15,45 @@
 #include <algorithm>
 #include <utility>
 #include <sstream>
+#include <cstdlib>
+#include <type_traits>
 
 #include "Constants.hpp"
 #include "Move.hpp"
 
+/**
+ * @brief Record of the board state that cannot be recovered from the move alone, pushed by MakeMove and copied back by UndoMove.
+*/
+struct StateInfo {
+    U64 hash; ///< Zobrist hash of the position before the move.
+    U64 enPassant; ///< En-passant target square before the move (empty bitboard if none).
+    unsigned short halfMoves; ///< Half-move clock before the move.
+    U16 move; ///< The move made from this position.
+    Piece movedPiece; ///< Type of the piece that was moved.
+    Piece takenPiece; ///< Type of the piece that was captured, null if nothing was taken.
+    U8 castlingRights; ///< Castling rights before the move.
+    int materialScore; ///< Material and piece-square score before the move.
+    int phaseMaterial; ///< Phase weight of the material before the move.
+};
+
+/**
+ * @brief Compact, trivially copyable copy of everything needed to reproduce a position. Used to restore the board in copy-make
+ * search or to hand a position to another board without touching the heap.
+*/
+struct PositionSnapshot {
+    U64 boards[12]; ///< Piece bitboards in the same order as Board::fBoards.
+    U64 hash; ///< Zobrist hash of the position.
+    U64 enPassant; ///< En-passant target square (empty bitboard if none).
+    int materialScore; ///< Material and piece-square score, so it need not be summed again on loading.
+    int phaseMaterial; ///< Phase weight of the material.
+    Color colorToMove; ///< Colour to make the next move.
+    unsigned short halfMoves; ///< Half-move clock.
+    unsigned short ply; ///< Number of moves made to reach the position.
+    U8 castlingRights; ///< Castling rights bitmask.
+};
+static_assert(std::is_trivially_copyable<PositionSnapshot>::value, "PositionSnapshot must be copyable with memcpy");
+static_assert(sizeof(PositionSnapshot) == 136, "PositionSnapshot is expected to fit in 136 bytes");
+
 /**
  * @class Board
  * @brief Abstract representation of the state of a chess board using a bitboard representation.
@@ -36,6 +71,19 @@ class Board {
          * @param other Reference to the board to copy.
         */
         Board(const Board& other);
+        /**
+         * @brief Export the current position as a compact snapshot.
+         * @return Snapshot of the bitboards, side to move, castling rights, en-passant square, clocks and hash.
+        */
+        PositionSnapshot GetSnapshot() const;
+        /**
+         * @brief Overwrite the current position with a snapshot. Only the mailbox entries of squares that differ are rewritten.
+         * The undo records are kept when the snapshot was taken earlier on this board, so restoring it is equivalent to undoing
+         * every move made since. Otherwise they belong to another game and are cleared, so a board loaded from another board's
+         * snapshot cannot undo past it or find repetitions from before it.
+         * @param snapshot The snapshot to load.
+        */
+        void LoadSnapshot(const PositionSnapshot &snapshot);
         /**
          * @brief Get the current state of the game can either be in play, stalemate or checkmate.
          * @return State, the enumeration for the current game state.
@@ -51,13 +99,13 @@ class Board {
          * @param piece The type of the piece.
          * @return U64, the bitboard containing the abstract representation of the piece positions.
          */
-        U64 GetBoard(const Color color, const Piece piece);
+        U64 GetBoard(const Color color, const Piece piece) const { return fBoards[(int)color * 6 + (int)piece - 1]; };
         /**
          * @brief Get the bit board associated with a particular piece for the colour to move.
          * @param piece The type of the piece.
          * @return The bitboard containing the abstract representation of the piece positions.
         */
-        U64 GetBoard(const Piece piece);
+        U64 GetBoard(const Piece piece) const { return GetBoard(fColorToMove, piece); };
         /**
          * @brief Get a pointer to the bitboard associated with a particular colour and type of piece.
          * @param color The color of the piece(s).
@@ -66,11 +114,11 @@ class Board {
         */
         U64* GetBoardPointer(const Color color, const Piece piece);
         /**
-         * @brief Get occupation bitboard for all pieces of specified colour.
+         * @brief Get occupation bitboard for all pieces of specified colour. Maintained incrementally so this is a single lookup.
          * @param color The color whose logical or of bitboards is required.
          * @return The bitboard containing the abstract representation of all pieces of color.
          */
-        U64 GetBoard(const Color color);
+        U64 GetBoard(const Color color) const { return fColorBoards[(int)color]; };
         /**
          * @brief Get occupation bitboard for all pieces with the specified colour and type found at the given position.
          * @param color The color of the pieces to search.
@@ -79,10 +127,10 @@ class Board {
          */
         U64 GetBoard(const Color color, const U64 occupiedPosition);
         /**
-         * @brief Return all occupied bits on the chess board as a bitboard.
+         * @brief Return all occupied bits on the chess board as a bitboard. Maintained incrementally so this is a single lookup.
          * @return The single bitboard occupancy of the entire game.
         */
-        U64 GetOccupancy() const { return std::accumulate(std::begin(fBoards), std::end(fBoards), U64(0), std::bit_or<U64>()); };
+        U64 GetOccupancy() const { return fOccupancy; };
         /**
          * @brief Get the colour of the player whose turn it is to move.
          * @return The colour whose turn it is to make a move.
@@ -99,6 +147,15 @@ class Board {
          * @brief Undoes the actions of the last move.
          */
         void UndoMove();
+        /**
+         * @brief Pass the turn to the other colour without moving a piece. Clears en-passant and pushes an undo record with a null move.
+         * Must be taken back with UndoNullMove.
+        */
+        void MakeNullMove();
+        /**
+         * @brief Undoes the last MakeNullMove.
+        */
+        void UndoNullMove();
         /**
          * @brief Loads a chess position from the FEN notation.
          * @param fen The FEN (Forthy Edwards Notation) string to load into the board.
@@ -106,62 +163,37 @@ class Board {
         void LoadFEN(const std::string &fen);
         /**
          * @brief Get whether a position on the board is occupied.
-         * @param pos The position on the board to check.
+         * @param pos The position on the board to check, must be a single set bit.
          * @return The color and piece type occupying the square. If nothing will return a white null piece.
         */
-        std::pair<Color, Piece> GetIsOccupied(const U64 pos) const;
+        std::pair<Color, Piece> GetIsOccupied(const U64 pos) const { return fMailbox[__builtin_ctzll(pos)]; };
         /**
         * @brief Get the Color and type of piece (if any) occupying the position
-        * @param pos The position on the board to check
+        * @param pos The position on the board to check, must be a single set bit.
         * @param color The color whose pieces occupancy should be checked.
         * @return The color and piece of the occupying piece (if any) else Null piece is given.
         */
-        std::pair<Color, Piece> GetIsOccupied(const U64 pos, const Color color) const;
+        std::pair<Color, Piece> GetIsOccupied(const U64 pos, const Color color) const { return fMailbox[__builtin_ctzll(pos)].first == color ? fMailbox[__builtin_ctzll(pos)] : std::make_pair(color, Piece::Null); };
         /**
         * @brief Get the number of completed moves full moves (e.g. both black and white have had a turn)
         * @return The number of completed turns (i.e. one move for white and one move for black)
         */
-        int GetNMovesMade() { return (int)(fMadeMoves.size() / 2); };
+        int GetNMovesMade() { return fPly / 2; };
         /**
          * @brief Get the number of individual moves made such that a move by white followed by black is 2 moves (1 turn).
          * @return Number of moves.
         */
-        int GetNMoves() { return (int)fMadeMoves.size(); };
-        /**
-         * @brief True if the white king has moved
-         * @return True if the white king has moved during the game.
-        */
-        bool GetWhiteKingMoved() { return fWhiteKingMoved > 0; };
-        /**
-         * @brief True if the black king has moved
-         * @return True if the black king has moved during the game.
-        */
-        bool GetBlackKingMoved() { return fBlackKingMoved > 0; };
-        /**
-         * @brief True if the white kingside rook has moved
-         * @return True if white's kingside rook has moved or been captured.
-        */
-        bool GetWhiteKingsideRookMoved() { return fWhiteKingsideRookMoved > 0; };
-        /**
-         * @brief True if the white queenside rook has moved
-         * @return True if the white queenside rook has moved or been captured.
-        */
-        bool GetWhiteQueensideRookMoved() { return fWhiteQueensideRookMoved > 0; };
+        int GetNMoves() { return fPly; };
         /**
-         * @brief True if the black kingside rook has moved
-         * @return True if the black kingside rook has moved or been captured.
+         * @brief Get the castling rights still available.
+         * @return Bitmask of CASTLING_WHITE_KINGSIDE, CASTLING_WHITE_QUEENSIDE, CASTLING_BLACK_KINGSIDE and CASTLING_BLACK_QUEENSIDE.
         */
-        bool GetBlackKingsideRookMoved() { return fBlackKingsideRookMoved > 0; };
-        /**
-         * @brief True if the black queenside rook has moved
-         * @return True if the black queenside rook has moved or been captured.
-        */
-        bool GetBlackQueensideRookMoved() { return fBlackQueensideRookMoved > 0; };
+        U8 GetCastlingRights() const { return fCastlingRights; };
         /**
          * @brief Get the last move made on the board.
          * @return The 32-bit move word. If no moves are made will return an empty 32-bit word.
         */
-        U16 GetLastMove() { return fMadeMoves.size() > 0 ? fMadeMoves.back() : U16(0); }
+        U16 GetLastMove() { return fPly > 0 ? fStates[fPly - 1].move : U16(0); }
         /**
          * @brief Overwrite the bitboard for the specified piece and colour with a new bitboard.
          * @param color The color of the piece.
@@ -180,9 +212,9 @@ class Board {
         bool GetWasLoadedFromFEN() { return fWasLoadedFromFEN; };
         /**
         * @brief Get the tile (or empty bitboard) that is available for en-passant capture 
-        * @return The square immedeately available for an en-passant capture when board has been loaded from FEN.
+        * @return The square the pawn that just double pushed skipped over, empty if the last move was not a double push.
         */
-        U64 GetEnPassantFEN() { return fEnPassantFENTarget; };
+        U64 GetEnPassantSquare() const { return fEnPassant; };
         /**
          * @brief Get the number of half-moves made since the last capture or pawn move.
          * @return The number of half moves made since the last pawn push or capture.
@@ -196,7 +228,12 @@ class Board {
         /**
          * @brief Returns a value between 0 and 1. Higher values indiciate a position closer to the "endgame".
         */
-        float GetGamePhase();
+        float GetGamePhase() const { return std::min(std::max((TOTAL_PHASE - fPhaseMaterial) / (float)TOTAL_PHASE, 0.f), 1.f); };
+        /**
+         * @brief Get the material plus piece-square score of every piece on the board, maintained incrementally by MakeMove and UndoMove.
+         * @return The score in centipawns, positive values favour white.
+        */
+        int GetMaterialScore() const { return fMaterialScore; };
         /**
          * @brief Creates and prints the FEN of the current board to the console.
         */
@@ -206,76 +243,55 @@ class Board {
          * @param move The move.
          * @return The piece type being moved.
         */
-        Piece GetMovePiece(const U16 move) const;
+        Piece GetMovePiece(const U16 move) const { return fMailbox[move & ORIGIN_MASK].second; };
         /**
          * @brief Get the type of piece being taken for the specified move. I.e. queries what is at TARGET. (Assumes move has not happened).
          * @param move The move.
          * @return The piece type being taken, null if no piece is taken.
         */
-        Piece GetMoveTakenPiece(const U16 move) const;
-        /**
-         * @brief Get if the move is an en-passant move.
-         * @param move The move to check.
-         * @param targetIsNull True if the tile being moved to when this move is happening is occupied by the null piece.
-         * @return True if the move is en-passant.
-        */
-        bool GetMoveIsEnPassant(const U16 move, const Piece movedPiece, const bool targetIsNull) const;
+        Piece GetMoveTakenPiece(const U16 move) const { return fMailbox[(move & TARGET_MASK) >> 6].second; };
         /**
          * @brief Get the type of the last piece moved.
          * @return The type of piece last moved.
         */
-        Piece GetLastPieceMoved() { return fMovedPieces.back(); };
+        Piece GetLastPieceMoved() { return fStates[fPly - 1].movedPiece; };
         /**
-         * @brief Calculates a semi-unique hash using the Zobrist keys previously generated for the current board state.
+         * @brief Get the semi-unique Zobrist hash of the current board state. Maintained incrementally by MakeMove and UndoMove.
+         * @return The Zobrist hash of the position.
         */
-        U64 GetHash();
+        U64 GetHash() const { return fHash; };
         /**
-         * @brief Get the vector of all positions reached by the board during play.
-         * @return Vector of zobrist hashed positions.
+         * @brief Calculates the Zobrist hash from scratch by visiting every square. Slow, use GetHash() unless checking the incremental hash.
+         * @return The Zobrist hash of the position.
         */
-        std::vector<U64> GetHistory() { return fHistory; };
+        U64 ComputeHash() const;
         /**
-         * @brief Adds the current board configuration to the history.
+         * @brief Get whether the current position has been reached before. Walks the hashes on the undo stack backwards two moves at a time
+         * (same side to move) and stops at the last capture, pawn move or null move, since no earlier position can repeat. No allocation.
+         * @param nPrevious Number of earlier occurrences needed, 2 for a threefold repetition or 1 to treat any repeat as a draw in search.
+         * @return True if the position occurred at least nPrevious times before.
         */
-        void AddCurrentHistory() { fHistory.push_back(GetHash()); };
-        /**
-         * @brief Clears the last item added to the board history.
-        */
-        void PopCurrentHistory() { fHistory.pop_back(); };
-        /**
-         * @brief Get the last element added to the history book.
-        */
-        U64 GetLastHistory() { return fHistory.back(); };
+        bool IsRepetition(const int nPrevious) const;
     private:
-        ZobristKeys fKeys; ///< Struct to hold keys for Zobrist board hashing.
+        U64 fHash; ///< Zobrist hash of the current position, updated incrementally as moves are made and undone.
         U64 fBoards[12]; ///< Array of 12 bitboards defining the postion. White pieces occupy boards 0-5 and black 6-12 in order (pawn, bishop, knight, rook, queen, king)
+        U64 fColorBoards[2]; ///< Occupancy of all white (0) and all black (1) pieces, kept in sync with fBoards.
+        U64 fOccupancy; ///< Occupancy of every piece on the board, the union of fColorBoards.
+        std::pair<Color, Piece> fMailbox[NSQUARES]; ///< Colour and type of the piece on each square indexed by LSB, kept in sync with fBoards. Empty squares hold a white null piece.
         // Move tracking
-        std::vector<U16> fMadeMoves; ///< Vector of moves made with the back of the vector being the last made move.
+        std::vector<StateInfo> fStates; ///< Undo records indexed by ply, allocated up front with MAX_GAME_PLY entries so MakeMove never grows it in practice. Their hashes double as the repetition history.
+        int fPly; ///< Number of moves made, the index of the next free record in fStates.
         unsigned short fHalfMoves; ///< The half-move clock for enforcing the 50 move rule.
-        std::vector<U64> fHistory; ///< Records the hashed positions reached during the game.
-
-        // For better move undoing
-        std::vector<Piece> fMovedPieces;
-        std::vector<Piece> fTakenPieces;
 
         // Game state variables
         State fGameState; ///< Current state of play in the game e.g. stalemate
-        unsigned short fWhiteKingMoved; ///< True if the white king has moved
-        unsigned short fBlackKingMoved; ///< True if the black king has moved
-        unsigned short fWhiteKingsideRookMoved; ///< >0 if the white kingside rook has moved or been captured.
-        unsigned short fWhiteQueensideRookMoved; ///< >0 if the white queenside rook has moved or been captured.
-        unsigned short fBlackKingsideRookMoved; ///< >0 if the black kingside rook has moved or been captured.
-        unsigned short fBlackQueensideRookMoved; ///< >0 if the black queenside rook has moved or been captured.
-        U64 fEnPassantFENTarget; ///< The tile in which an en-passant move is now available (as read from a FEN string)
+        U8 fCastlingRights; ///< Bitmask of the castling rights still available, see CASTLING_WHITE_KINGSIDE etc.
+        U64 fEnPassant; ///< The tile in which an en-passant capture is now available, empty if the last move was not a double pawn push.
         Color fColorToMove; ///< Current colour to make a move
 
-        // Variables for quickly calculating a rough game phase
-        const int fPawnPhase;
-        const int fKnightPhase;
-        const int fBishopPhase;
-        const int fRookPhase;
-        const int fQueenPhase;
-        float fTotalPhase;
+        // Evaluation terms kept up to date as pieces move
+        int fMaterialScore; ///< Sum of PIECE_SQUARE_SCORES over every piece on the board.
+        int fPhaseMaterial; ///< Sum of PHASE_WEIGHTS over every piece on the board, TOTAL_PHASE in the starting position.
 
         // Skipping functions
         bool fWasLoadedFromFEN; ///< Get if the board was loaded from FEN
@@ -285,9 +301,34 @@ class Board {
         */
         void EmptyBoards();
         /**
-         * @brief Fill the arrays for the Zobrist key hashing. Randomly generates keys using a hardware generated seed.
+         * @brief Rebuild the square-indexed mailbox, the colour and total occupancy bitboards, the material score and the phase from the piece bitboards.
+        */
+        void FillMailbox();
+        /**
+         * @brief Get the material plus piece-square score for a piece of the given colour and type sitting on a square.
+         * @param color The colour of the piece.
+         * @param piece The type of the piece.
+         * @param square The LSB of the square.
+         * @return The score, negative for black pieces.
+        */
+        int GetPieceScore(const Color color, const Piece piece, const int square) const { return PIECE_SQUARE_SCORES[(int)color][(int)piece][square]; };
+        /**
+         * @brief Get the Zobrist key for a piece of the given colour and type sitting on a square.
+         * @param color The colour of the piece.
+         * @param piece The type of the piece.
+         * @param square The bitboard with a single set bit at the square.
+         * @return The Zobrist key.
+        */
+        U64 GetPieceKey(const Color color, const Piece piece, const U64 square) const { return ZOBRIST_KEYS.pieceKeys[__builtin_ctzll(square)][(int)piece + (color == Color::White ? 0 : 6)]; };
+        /**
+         * @brief Get the Zobrist key for the en-passant file available to the colour to move.
+         * @return The en-passant key for the file, zero if no en-passant capture is available.
+        */
+        U64 GetEnPassantKey() const;
+        /**
+         * @brief Compare the incremental hash, mailbox, occupancy bitboards, material score and phase against a full recomputation from the bitboards and abort on mismatch. Only called when built with DEBUG_HASH.
         */
-        void InitZobristKeys();
+        void VerifyIncrementalState() const;
 };
 
 #endif
\ No newline at end of file
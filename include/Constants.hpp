@@ -5,10 +5,12 @@
 #include <string>
 #include <cstdint>
 #include <array>
-#include <random>
+#include <limits>
 #include <vector>
 #include <bitset>
 
+#include "Cpu.hpp"
+
 /**
  * @brief Typedef for U64 using unsigned long long.
  *
@@ -25,7 +27,7 @@ typedef uint32_t U32;
 typedef uint16_t U16;
 typedef uint8_t U8;
 
-constexpr U8 AVERAGE_MOVES_PER_POSITION{32};
+constexpr int MAX_MOVES{256}; ///< Capacity of a MoveList, comfortably above the most legal moves possible in any position (218).
 
 /**
  * @file Constants.hpp
@@ -156,39 +158,130 @@ enum class Piece {
 constexpr int NSQUARES = 64;
 constexpr int BITS_PER_FILE = 8;
 constexpr int MIN_MOVES_FOR_CASTLING = 6;
-constexpr int MIN_MOVES_FOR_ENPASSANT = 3;
-
-const float VALUE_PAWN = 100.; // centi-pawn value
-const float VALUE_BISHOP = 330.;
-const float VALUE_KNIGHT = 320.;
-const float VALUE_ROOK = 500.;
-const float VALUE_QUEEN = 900.;
-const float VALUE_KING = 99999.;
+constexpr int MAX_GAME_PLY = 1024; ///< Number of undo records a board allocates up front, enough for any realistic game plus search.
+constexpr int MAX_SEARCH_PLY = 64; ///< Deepest ply from the root that keeps killer moves.
+
+// Castling rights bitmask
+constexpr U8 CASTLING_WHITE_KINGSIDE = 0b0001;
+constexpr U8 CASTLING_WHITE_QUEENSIDE = 0b0010;
+constexpr U8 CASTLING_BLACK_KINGSIDE = 0b0100;
+constexpr U8 CASTLING_BLACK_QUEENSIDE = 0b1000;
+constexpr U8 CASTLING_ALL = 0b1111;
+constexpr char CASTLING_FEN_CHARS[4] = {'K', 'Q', 'k', 'q'}; ///< FEN letter for each castling right, in bit order.
+
+constexpr float VALUE_PAWN = 100.; // centi-pawn value
+constexpr float VALUE_BISHOP = 330.;
+constexpr float VALUE_KNIGHT = 320.;
+constexpr float VALUE_ROOK = 500.;
+constexpr float VALUE_QUEEN = 900.;
+constexpr float VALUE_KING = 99999.;
 
 constexpr float MAX_EVAL = std::numeric_limits<float>::max();
 constexpr float MIN_EVAL = -std::numeric_limits<float>::max();
 
+// Null-move pruning
+constexpr int NULL_MOVE_REDUCTION = 2; ///< Extra depth reduction for the search after passing the turn.
+constexpr int NULL_MOVE_MIN_DEPTH = NULL_MOVE_REDUCTION + 1; ///< Shallowest remaining depth at which a null move is tried.
+constexpr float NULL_MOVE_VERIFY_PHASE = 0.7; ///< Game phase above which a null-move cutoff is confirmed by a reduced search, zugzwang is common in endgames.
+
+// Move ordering
+constexpr int QUIET_CHECK_BONUS = 50; ///< Ordering score added to quiet moves that give check, so they are searched before other quiets.
+
 const float PIECE_VALUES[7] = {0., VALUE_PAWN, VALUE_BISHOP, VALUE_KNIGHT, VALUE_ROOK, VALUE_QUEEN, VALUE_KING};
 const std::vector<Piece> PROMOTION_PIECES = {Piece::Bishop, Piece::Knight, Piece::Rook, Piece::Queen};
 
+// Piece-square tables, indexed by LSB (H1 = 0). Two-row tables are 0 for white and 1 for black.
+constexpr float KNIGHT_POS_MODIFIER[64] = { ///< Value modifier for the knight based on its position on the board
+    -50,-40,-30,-30,-30,-30,-40,-50, // H1, G1, F1, E1, D1, C1, B1, A1 (7)
+    -40,-20,  0,  5,  5,  0,-20,-40, // H2, ... A2
+    -30,  5, 10, 15, 15, 10,  5,-30, // H3, ... A3
+    -30,  0, 15, 20, 20, 15,  0,-30, // H4, ... A4
+    -30,  5, 15, 20, 20, 15,  5,-30, // H5, ... A5
+    -30,  0, 10, 15, 15, 10,  0,-30, // H6, ... A6
+    -40,-20,  0,  0,  0,  0,-20,-40, // H7, ... A7
+    -50,-40,-30,-30,-30,-30,-40,-50  // H8, ... A8
+};
+
+constexpr float QUEEN_POS_MODIFIER[64] = { ///< Value modifier for the queen based on its position on the board
+    -20,-10,-10, -5, -5,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5,  5,  5,  5,  0,-10,
+    -5,   0,  5,  5,  5,  5,  0, -5,
+     0,   0,  5,  5,  5,  5,  0, -5,
+    -10,  5,  5,  5,  5,  5,  0,-10,
+    -10,  0,  5,  0,  0,  0,  0,-10,
+    -20,-10,-10, -5, -5,-10,-10,-20
+};
+
+constexpr float ROOK_POS_MODIFIER[2][64] = {{ ///< Value modifier for the rook based on its position on the board, 0th for white, 1st for black
+    0,  0,  0,  5,  5,  0,  0,  0,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    5, 10, 10, 10, 10, 10, 10,  5,
+    0,  0,  0,  0,  0,  0,  0,  0    
+},
+{
+    0,  0,  0,  0,  0,  0,  0,  0,
+    5, 10, 10, 10, 10, 10, 10,  5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    0,  0,  0,  5,  5,  0,  0,  0
+}};
+
+constexpr float BISHOP_POS_MODIFIER[2][64] = {{ ///< Value modifier for the bishop based on its position on the board
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20,
+}, {
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20,
+}};
+
+constexpr int PHASE_WEIGHTS[7] = {0, 0, 1, 1, 2, 4, 0}; ///< Contribution of each piece type (null, pawn, bishop, knight, rook, queen, king) to the game phase.
+constexpr int TOTAL_PHASE = 16*PHASE_WEIGHTS[1] + 4*PHASE_WEIGHTS[2] + 4*PHASE_WEIGHTS[3] + 4*PHASE_WEIGHTS[4] + 2*PHASE_WEIGHTS[5]; ///< Phase weight of the starting material.
+
+/**
+ * @brief Material plus piece-square score of a piece by colour, piece type and LSB. Black entries are negated so summing over
+ * every piece gives the score from white's point of view. Kings and the pawn square bonus are left out to match Engine::Evaluate.
+*/
+constexpr std::array<std::array<std::array<int, 64>, 7>, 2> PIECE_SQUARE_SCORES = [] {
+    std::array<std::array<std::array<int, 64>, 7>, 2> scores{};
+    for(int color = 0; color < 2; ++color) {
+        const int sign = color == 0 ? 1 : -1;
+        for(int sq = 0; sq < 64; ++sq) {
+            scores[color][(int)Piece::Pawn][sq] = sign * (int)VALUE_PAWN;
+            scores[color][(int)Piece::Bishop][sq] = sign * (int)(VALUE_BISHOP + BISHOP_POS_MODIFIER[color][sq]);
+            scores[color][(int)Piece::Knight][sq] = sign * (int)(VALUE_KNIGHT + KNIGHT_POS_MODIFIER[sq]);
+            scores[color][(int)Piece::Rook][sq] = sign * (int)(VALUE_ROOK + ROOK_POS_MODIFIER[color][sq]);
+            scores[color][(int)Piece::Queen][sq] = sign * (int)(VALUE_QUEEN + QUEEN_POS_MODIFIER[sq]);
+        }
+    }
+    return scores;
+}();
+
 inline int pop_LSB(U64 &b) {
     int i = __builtin_ctzll(b);
     b &= b - 1;
     return i;
 }
 
-inline U64 reverse(U64 b) {
-    b = (b & 0x5555555555555555) << 1 | ((b >> 1) & 0x5555555555555555);
-    b = (b & 0x3333333333333333) << 2 | ((b >> 2) & 0x3333333333333333);
-    b = (b & 0x0f0f0f0f0f0f0f0f) << 4 | ((b >> 4) & 0x0f0f0f0f0f0f0f0f);
-    b = (b & 0x00ff00ff00ff00ff) << 8 | ((b >> 8) & 0x00ff00ff00ff00ff);
-    return (b << 48) | ((b & 0xffff0000) << 16) | ((b >> 16) & 0xffff0000) | (b >> 48);
-}
-
-inline U64 hypQuint(U64 piece, U64 occupancy, U64 mask) {
-    return (((mask & occupancy) - piece * 2) ^ reverse(reverse(mask & occupancy) - reverse(piece) * 2)) & mask;
-}
-
 inline int PrintBitset(U64 b) {
     std::bitset<64> x = b;
     std::string s = x.to_string();
@@ -238,6 +331,23 @@ constexpr U64 SQUARE_D8 = FILE_D & RANK_8;
 constexpr U64 SQUARE_G8 = FILE_G & RANK_8;
 constexpr U64 SQUARE_C8 = FILE_C & RANK_8;
 
+/**
+ * @brief Castling rights that survive a move touching each square, indexed by LSB. MakeMove ANDs in the entries for the
+ * origin and target so moving a king or rook, or capturing a rook on its home square, drops the matching rights.
+*/
+constexpr std::array<U8, 64> CASTLING_RIGHTS_MASK = [] {
+    std::array<U8, 64> mask{};
+    for(U8 &rights : mask)
+        rights = CASTLING_ALL;
+    mask[__builtin_ctzll(FILE_E & RANK_1)] &= ~(CASTLING_WHITE_KINGSIDE | CASTLING_WHITE_QUEENSIDE);
+    mask[__builtin_ctzll(SQUARE_H1)] &= ~CASTLING_WHITE_KINGSIDE;
+    mask[__builtin_ctzll(SQUARE_A1)] &= ~CASTLING_WHITE_QUEENSIDE;
+    mask[__builtin_ctzll(FILE_E & RANK_8)] &= ~(CASTLING_BLACK_KINGSIDE | CASTLING_BLACK_QUEENSIDE);
+    mask[__builtin_ctzll(SQUARE_H8)] &= ~CASTLING_BLACK_KINGSIDE;
+    mask[__builtin_ctzll(SQUARE_A8)] &= ~CASTLING_BLACK_QUEENSIDE;
+    return mask;
+}();
+
 constexpr U64 WHITE_KING_CORNERS = (FILE_A | FILE_B | FILE_C | FILE_G | FILE_H) & RANK_1;
 constexpr U64 BLACK_KING_CORNERS = (FILE_A | FILE_B | FILE_C | FILE_G | FILE_H) & RANK_8;
 
@@ -264,6 +374,10 @@ constexpr U64 north_east(U64 b) { return (b & ~FILE_H) << 7; }
 constexpr U64 south_west(U64 b) { return (b & ~FILE_A) >> 7; }
 constexpr U64 north_west(U64 b) { return (b & ~FILE_A) << 9; }
 
+constexpr Color opposite(Color c) { return c == Color::White ? Color::Black : Color::White; }
+template<Color C> constexpr U64 pawn_push(U64 b) { return C == Color::White ? north(b) : south(b); } // One rank towards C's promotion rank
+template<Color C> constexpr U64 pawn_attacks(U64 b) { return C == Color::White ? north_east(b) | north_west(b) : south_east(b) | south_west(b); }
+
 const U64 KING_SIDE_CASTLING_MASK_WHITE = RANK_1 & (FILE_F | FILE_G);
 const U64 QUEEN_SIDE_CASTLING_MASK_WHITE = RANK_1 & (FILE_C | FILE_D);
 const U64 KING_SIDE_CASTLING_MASK_BLACK = RANK_8 & (FILE_F | FILE_G);
@@ -274,8 +388,13 @@ const U64 QUEEN_SIDE_CASTLING_OCCUPANCY_MASK_WHITE = RANK_1 & (FILE_C | FILE_D |
 const U64 KING_SIDE_CASTLING_OCCUPANCY_MASK_BLACK = RANK_8 & (FILE_F | FILE_G);
 const U64 QUEEN_SIDE_CASTLING_OCCUPANCY_MASK_BLACK = RANK_8 & (FILE_C | FILE_D | FILE_B);
 
+/**
+ * @brief Count the set bits of a bitboard, dispatched to hardware POPCNT when DetectCpuFeatures found it.
+ * @param number The bitboard.
+ * @return Number of set bits.
+*/
 inline int CountSetBits(U64 number) {
-    return __builtin_popcountll(number);
+    return PopCount(number);
 }
 
 inline U64 get_rank(U64 position) {
@@ -455,14 +574,49 @@ constexpr int NUM_SQUARES = 64; // Number of squares on the board
 struct ZobristKeys {
     std::array<std::array<U64, NUM_PIECE_TYPES>, NUM_SQUARES> pieceKeys;
     std::array<U64, 2> sideToMoveKey;
-    std::array<U64, 4> castlingKeys; // Whether the player can or cannot castle. White = [0,3] black = [4,7]. Then goes kingside/queenside, yes/no e.g. WKY, WQY, WKN, WQN.
-    U64 enPassantKey;
+    std::array<U64, 16> castlingKeys; // One key per value of the castling rights bitmask so the key is a single lookup.
+    std::array<U64, 8> enPassantKeys; // One key per file of the square available for en-passant capture, A = 0.
 };
 
-inline U64 GetRandomKey() {
-    static std::mt19937_64 rng(std::random_device{}());
-    static std::uniform_int_distribution<U64> dist;
-    return dist(rng);
+constexpr U64 ZOBRIST_SEED = 0x9E3779B97F4A7C15ULL; ///< Fixed seed so hashes are identical across runs and processes.
+
+/**
+ * @brief Advance a SplitMix64 generator and return the next key, usable at compile time.
+ * @param state The generator state, updated in place.
+ * @return The next pseudo-random 64-bit key.
+*/
+constexpr U64 NextZobristKey(U64 &state) {
+    U64 z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Generate every Zobrist key from ZOBRIST_SEED.
+ * @return The filled key tables.
+*/
+constexpr ZobristKeys GenerateZobristKeys() {
+    ZobristKeys keys{};
+    U64 state = ZOBRIST_SEED;
+    for(int i = 0; i < NUM_SQUARES; ++i) {
+        for(int j = 1; j < NUM_PIECE_TYPES; ++j) // Entry 0 is the empty square and never hashed
+            keys.pieceKeys[i][j] = NextZobristKey(state);
+    }
+    keys.sideToMoveKey[0] = NextZobristKey(state); // White to move
+    keys.sideToMoveKey[1] = NextZobristKey(state); // Black to move
+    // Key for a set of rights is the XOR of the keys for each right on its own
+    for(int i = 0; i < 4; ++i)
+        keys.castlingKeys[1 << i] = NextZobristKey(state);
+    for(int rights = 1; rights < 16; ++rights) {
+        const int lowest = rights & -rights;
+        keys.castlingKeys[rights] = keys.castlingKeys[lowest] ^ keys.castlingKeys[rights ^ lowest];
+    }
+    for(int i = 0; i < 8; ++i)
+        keys.enPassantKeys[i] = NextZobristKey(state);
+    return keys;
 }
 
+inline constexpr ZobristKeys ZOBRIST_KEYS = GenerateZobristKeys(); ///< Zobrist keys shared by every board, built at compile time.
+
 #endif
\ No newline at end of file
@@ -0,0 +1,71 @@
+/**
+ * @file Cpu.hpp
+ * @brief Runtime detection of optional CPU instructions and the bit twiddling that dispatches on them.
+ */
+
+#ifndef CPU_HPP
+#define CPU_HPP
+
+#include <cstdint>
+
+/**
+ * @brief Optional instructions found on the host CPU. Everything starts off false so the portable code paths are
+ * used until DetectCpuFeatures has run.
+*/
+struct CpuFeatures {
+    bool popcnt = false; ///< Hardware POPCNT is available.
+    bool bmi2 = false; ///< BMI2 (and so PEXT) is available and fast, Zen 1 and Zen 2 microcode PEXT so are left out.
+};
+
+inline CpuFeatures CPU_FEATURES; ///< Features of the host CPU, filled once by DetectCpuFeatures.
+
+/**
+ * @brief Query the CPU for the optional instructions and fill CPU_FEATURES. Setting the environment variable
+ * CHESSENGINE_PORTABLE forces the portable fallbacks, e.g. to check them on a machine that has BMI2.
+*/
+void DetectCpuFeatures();
+
+/**
+ * @brief Count the set bits of a 64-bit number with POPCNT when the CPU has it, or the portable builtin otherwise.
+ * @param b The 64-bit number.
+ * @return Number of set bits.
+*/
+inline int PopCount(const std::uint64_t b) {
+#if defined(__POPCNT__) || !defined(__x86_64__)
+    return __builtin_popcountll(b);
+#else
+    // Inline assembly is not subject to the target checks of the compiler, so one binary can carry both paths
+    if(CPU_FEATURES.popcnt) {
+        std::uint64_t count;
+        asm("popcntq %1, %0" : "=r" (count) : "r" (b));
+        return (int)count;
+    }
+    return __builtin_popcountll(b);
+#endif
+}
+
+/**
+ * @brief Gather the bits of b selected by mask into the low bits of the result. Only call when CPU_FEATURES.bmi2 is set.
+ * @param b The 64-bit number to extract from.
+ * @param mask The bits to extract.
+ * @return The extracted bits packed from bit 0 upwards.
+*/
+inline std::uint64_t ParallelExtract(const std::uint64_t b, const std::uint64_t mask) {
+#if defined(__x86_64__)
+    std::uint64_t result;
+    asm("pextq %2, %1, %0" : "=r" (result) : "r" (b), "r" (mask));
+    return result;
+#else
+    // Never selected off x86, kept so the portable build still links
+    std::uint64_t result = 0;
+    std::uint64_t remaining = mask;
+    for(std::uint64_t bit = 1; remaining; bit <<= 1) {
+        if(b & remaining & -remaining)
+            result |= bit;
+        remaining &= remaining - 1;
+    }
+    return result;
+#endif
+}
+
+#endif
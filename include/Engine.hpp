@@ -19,6 +19,7 @@
 #include "Board.hpp"
 #include "Move.hpp"
 #include "Generator.hpp"
+#include "MovePicker.hpp"
 
 /**
  * @class Engine
@@ -40,28 +41,35 @@ class Engine {
         /**
          * @brief Add a bonus to the evaluation score for each passed pawn. This is especially true when the phase
          * of the game is endgame-like.
+         * @tparam Us The colour to move.
          * @return The bonus to add to the evaluation in centipawns.
         */
+        template<Color Us>
         float EvaluatePassedPawns();
         /**
          * @brief Add a penalty for isolated pawns. Especially those towards the centre as they are more vulnerable.
+         * @tparam Us The colour to move.
          * @return Penalty to apply (negative value) to the evaluation.
         */
+        template<Color Us>
         float EvaluateIsolatedPawns();
         /**
          * @brief Add a penalty for "bad" bishops i.e. those who are unable to progress forwards fully due to being blocked
          * by your own pawns.
+         * @tparam Us The colour to move.
          * @return Penalty to apply (negative value).
         */
+        template<Color Us>
         float EvaluateBadBishops();
         /**
          * @brief Get the true evaluation of a position in centipawns. Positive values favour white whilst negative values favour black.
          * @param depth The maximum depth to search to.
          * @param alpha Alpha cut off value for alpha-beta pruning.
          * @param beta Beta cut off value for alpha-beta pruning.
+         * @param allowNullMove Whether this node may try null-move pruning, false straight after a null move and in verification searches.
          * @return Evaluation of the board in centipawns.
         */
-        float Search(U8 depth, float alpha, float beta, bool maximising);
+        float Search(U8 depth, float alpha, float beta, bool maximising, bool allowNullMove = true);
         /**
          * @brief Change the difficulty of the engine with higher values meaning a stronger engine. Values are designed to be elo values.
          * Also clears the previously evaluation cache since we don't want to use old potentially worse/better evaluations when the difficulty changes. We will change the difficulty by making the evaluation function simpler.
@@ -73,6 +81,21 @@ class Engine {
          * @return Difficulty of the engine in elo.
         */
         int GetDifficulty() { return fDifficulty; };
+        /**
+         * @brief Get the number of positions searched during the last call to GetBestMove.
+         * @return Number of positions searched.
+        */
+        int GetNMovesSearched() { return fNMovesSearched; };
+        /**
+         * @brief Choose how the search takes back moves. Copy-make restores a PositionSnapshot saved before each move instead of calling UndoMove.
+         * @param copyMake True to search with copy-make, false for make/unmake.
+        */
+        void SetCopyMake(bool copyMake) { fCopyMake = copyMake; };
+        /**
+         * @brief Get whether the search takes back moves by restoring a snapshot (copy-make) rather than UndoMove.
+         * @return True if searching with copy-make.
+        */
+        bool GetCopyMake() { return fCopyMake; };
 
 
 
@@ -97,6 +120,9 @@ class Engine {
         int fMaxDepth;
         float fGamePhase;
         int fDifficulty; ///< Difficulty of the chess engine, values correspond to approximate chess ELO ratings
+        bool fCopyMake; ///< Take back search moves by restoring a snapshot instead of UndoMove
+        int fRootPly; ///< Ply of the board at the root of the current search, used to find the ply of a node.
+        U16 fKillerMoves[MAX_SEARCH_PLY][2]; ///< The two most recent quiet moves causing a cut off at each ply from the root.
 
         const int fPassPawnBonus[6] = {50, 40, 30, 20, 10, 5}; ///< Distance from left to right so 0th = 1 square from promo values are in centipawns
         const int fIsolatedPawnPenaltyByFile[8] = {-10, -15, -25, -30, -30, -25, -15, -10};
@@ -104,69 +130,6 @@ class Engine {
 
         const float fPawnGuardKingEval[4] = {-200, 50, 100, 120};
 
-        const float fKnightPosModifier[64] = { ///< Value modifier for the knight based on its position on the board
-            -50,-40,-30,-30,-30,-30,-40,-50, // H1, G1, F1, E1, D1, C1, B1, A1 (7)
-            -40,-20,  0,  5,  5,  0,-20,-40, // H2, ... A2
-            -30,  5, 10, 15, 15, 10,  5,-30, // H3, ... A3
-            -30,  0, 15, 20, 20, 15,  0,-30, // H4, ... A4
-            -30,  5, 15, 20, 20, 15,  5,-30, // H5, ... A5
-            -30,  0, 10, 15, 15, 10,  0,-30, // H6, ... A6
-            -40,-20,  0,  0,  0,  0,-20,-40, // H7, ... A7
-            -50,-40,-30,-30,-30,-30,-40,-50  // H8, ... A8
-        };
-
-        const float fQueenPosModifier[64] = { ///< Value modifier for the queen based on its position on the board
-            -20,-10,-10, -5, -5,-10,-10,-20,
-            -10,  0,  0,  0,  0,  0,  0,-10,
-            -10,  0,  5,  5,  5,  5,  0,-10,
-            -5,   0,  5,  5,  5,  5,  0, -5,
-             0,   0,  5,  5,  5,  5,  0, -5,
-            -10,  5,  5,  5,  5,  5,  0,-10,
-            -10,  0,  5,  0,  0,  0,  0,-10,
-            -20,-10,-10, -5, -5,-10,-10,-20
-        };
-
-        const float fRookPosModifier[2][64] = {{ ///< Value modifier for the rook based on its position on the board, 0th for white, 1st for black
-            0,  0,  0,  5,  5,  0,  0,  0,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            5, 10, 10, 10, 10, 10, 10,  5,
-            0,  0,  0,  0,  0,  0,  0,  0    
-        },
-        {
-            0,  0,  0,  0,  0,  0,  0,  0,
-            5, 10, 10, 10, 10, 10, 10,  5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            -5,  0,  0,  0,  0,  0,  0, -5,
-            0,  0,  0,  5,  5,  0,  0,  0
-        }};
-
-        const float fBishopPosModifier[2][64] = {{ ///< Value modifier for the bishop based on its position on the board
-            -20,-10,-10,-10,-10,-10,-10,-20,
-            -10,  5,  0,  0,  0,  0,  5,-10,
-            -10, 10, 10, 10, 10, 10, 10,-10,
-            -10,  0, 10, 10, 10, 10,  0,-10,
-            -10,  5,  5, 10, 10,  5,  5,-10,
-            -10,  0,  5, 10, 10,  5,  0,-10,
-            -10,  0,  0,  0,  0,  0,  0,-10,
-            -20,-10,-10,-10,-10,-10,-10,-20,
-        }, {
-            -20,-10,-10,-10,-10,-10,-10,-20,
-            -10,  0,  0,  0,  0,  0,  0,-10,
-            -10,  0,  5, 10, 10,  5,  0,-10,
-            -10,  5,  5, 10, 10,  5,  5,-10,
-            -10,  0, 10, 10, 10, 10,  0,-10,
-            -10, 10, 10, 10, 10, 10, 10,-10,
-            -10,  5,  0,  0,  0,  0,  5,-10,
-            -20,-10,-10,-10,-10,-10,-10,-20,
-        }};
-
         const float fKingPosModifier[4][64] = {{
             20, 30, 10,  0,  0, 10, 30, 20,
             20, 20,  0,  0,  0,  0, 20, 20,
@@ -208,47 +171,85 @@ class Engine {
         //std::random_device fRandomDevice;
 
         /**
-         * @brief Search until no more captures are available.
+         * @brief Search until no more captures are available, skipping captures that lose material by static exchange evaluation.
+         * Not yet called by Search, which evaluates the position directly at depth 0, so during search SEE only splits the
+         * MovePicker captures into good and bad.
          * @param alpha Current value of alpha from minimax.
          * @param beta Current value of beta from minimax.
          * @return Evaluation of the position.
         */
         float SearchAllCaptures(float alpha, float beta, bool maximising);
         /**
-         * @brief Counts up the knight material on both sides taking into account the positional value.
-         * @return The value of the material with positive values favouring white.
+         * @brief Make a move during search, first saving the position to snapshot when searching with copy-make.
+         * @param move The move to make.
+         * @param snapshot Filled with the position before the move when copy-make is enabled, untouched otherwise.
         */
-        float EvaluateKingPositions();
+        void MakeSearchMove(const U16 move, PositionSnapshot &snapshot);
         /**
-         * @brief Counts up the knight material on both sides taking into account the positional value.
-         * @return The value of the material with positive values favouring white.
+         * @brief Take back the last move made by MakeSearchMove.
+         * @param snapshot The snapshot filled by the matching MakeSearchMove call.
         */
-        float EvaluateKnightPositions();
+        void UndoSearchMove(const PositionSnapshot &snapshot);
         /**
-         * @brief Counts up the queen material on both sides taking into account the positional value.
-         * @return The value of the material with positive values favouring white.
+         * @brief Remember a quiet move that caused a cut off so sibling nodes try it early.
+         * @param move The move causing the cut off.
         */
-        float EvaluateQueenPositions();
+        void StoreKillerMove(const U16 move);
         /**
-         * @brief Counts up the rook material on both sides taking into account the positional value.
-         * @return The value of the material with positive values favouring white.
+         * @brief Get the killer moves for the current ply of the board.
+         * @return The two killer moves, either may be 0.
         */
-        float EvaluateRookPositions();
+        const U16* GetKillerMoves();
         /**
-         * @brief Counts up the bishop material on both sides taking into account the positional value.
+         * @brief Try passing the turn and searching at reduced depth. If the side to move still beats the bound the node can be cut off.
+         * @param depth The remaining depth of the node.
+         * @param alpha Current value of alpha from minimax.
+         * @param beta Current value of beta from minimax.
+         * @param maximising True if the side to move is white.
+         * @param inCheck True if the side to move is in check, passing is then illegal.
+         * @param evaluation Set to the bound to return when pruning.
+         * @return True if the node can be pruned.
+        */
+        bool TryNullMovePruning(U8 depth, float alpha, float beta, bool maximising, bool inCheck, float &evaluation);
+        /**
+         * @brief Counts up the knight material on both sides taking into account the positional value.
          * @return The value of the material with positive values favouring white.
         */
-        float EvaluateBishopPositions();
+        float EvaluateKingPositions();
         /**
          * @brief Considers the position of the current king and how safe that is considering the current phase of the game. 
+         * @tparam Us The colour to move.
          * @return The value to enhance or reduce the evaluation of the position by based on the king safety (positive values are better).
         */
+        template<Color Us>
         float EvaluateKingSafety();
+        /**
+         * @brief The king safety of one side, the contribution EvaluateKingSafety adds for that side's king.
+         * @tparam C The colour whose king is evaluated.
+         * @return Positive values are good for colour C.
+        */
+        template<Color C>
+        float EvaluateKingSafetyOf();
+        /**
+         * @brief The bad bishop penalty of one side, the contribution EvaluateBadBishops adds for that side's bishops.
+         * @tparam C The colour whose bishops are evaluated.
+         * @return Penalty for colour C (negative value).
+        */
+        template<Color C>
+        float EvaluateBadBishopsOf();
+        /**
+         * @brief Sum the positional terms enabled by the difficulty, specialised for the colour to move so none of them
+         * branch on it.
+         * @tparam Us The colour to move.
+         * @return The positional evaluation with positive values favouring white.
+        */
+        template<Color Us>
+        float EvaluatePosition();
 
         // TODO: Reward rook pair, bishop pair over knight pair, rooks on open files.
 
         float GetMaterialEvaluation();
-        void OrderMoves(std::vector<U16> &moves);
+        void OrderMoves(MoveList &moves, const AttackInfo &info);
 
 };
 
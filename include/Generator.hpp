@@ -14,55 +14,217 @@
 #include "Constants.hpp"
 #include "Board.hpp"
 #include "Move.hpp"
+#include "Magics.hpp"
+#include "AttackTables.hpp"
+#include "MoveList.hpp"
+
+/**
+ * @brief The kinds of move a generation call produces.
+*/
+enum class MoveGenType {
+    Captures, ///< Captures, including en-passant and capturing promotions.
+    Quiets, ///< Moves that capture nothing, including castling and quiet promotions.
+    Evasions, ///< Every legal move when in check: king moves, captures of the checker and blocks. Nothing when not in check.
+    QuietChecks, ///< Moves that capture nothing and give check, excluding castling and promotions. Nothing when in check.
+    All ///< Every legal move.
+};
+
+/**
+ * @brief Attack information about a position: checkers, pins and the squares attacked by the enemy. Worked out once per
+ * search node by UpdateAttackInfo and shared by each stage of move generation, castling, mate detection and move
+ * ordering, so none of them recompute attacks. Lives on the stack of its user so the Generator holds no per-call state.
+*/
+struct AttackInfo {
+    U64 occupancy; ///< Total occupancy of the board.
+    U64 enemy; ///< Occupancy bit board of the colour not to move.
+    U64 king; ///< Position of the king whose colour it is to move.
+    U64 checkers; ///< Enemy pieces giving check to the king to move.
+    U64 checkMask; ///< Squares a non-king move must land on to resolve check: the checker and the squares between it and the king. All squares when not in check, none in double check.
+    U64 pinned; ///< Our pieces that are absolutely pinned to the king.
+    U64 pinRays[NSQUARES]; ///< For each pinned piece (by LSB) the ray from the king to the pinning piece, including the pinner. Only valid where pinned is set.
+    U64 enemyAttacks; ///< Squares attacked by the enemy with our king removed from the board, so the king cannot retreat along a checking ray.
+    U64 enemyPawnAttacks; ///< Squares attacked by the enemy pawns, used to order moves.
+};
+
+/**
+ * @brief The squares from which each type of our pieces would check the enemy king, and our pieces that discover check
+ * by leaving their line to it.
+*/
+struct CheckInfo {
+    U8 enemyKingLSB; ///< LSB of the king of the colour not to move.
+    U64 checkSquares[(int)Piece::King + 1]; ///< Squares a piece of each type (indexed by Piece) would attack the enemy king from, none for the king.
+    U64 discoveryCandidates; ///< Our pieces that are the only blocker between one of our sliders and the enemy king.
+};
 
 /**
  * @class Generator
  * @brief Handles generation of legal moves.
  * 
- * The Generator class is used to handle the computation necessary to play the game with the user and all legal computer moves. The generator can check for move legality. It uses pre-generated attack tables to speed up computation.
+ * The Generator class is used to handle the computation necessary to play the game with the user and all legal computer moves. The generator can check for move legality. It uses attack tables computed at compile time, shared by every instance, to speed up computation.
+ * Generating into a caller-owned MoveList is const and keeps no state between calls, so one Generator can serve any number of threads each searching their own Board.
  */ 
 class Generator {
     public:
         /**
-         * @brief Instantiate a new instance of the Generator class.
+         * @brief Instantiate a new instance of the Generator class. The slider tables are only built by the first instance.
         */
         explicit Generator();
         /**
-         * @brief Generate all legal moves given a board configuration. Moves are stored in the fLegalMoves vector.
+         * @brief Generate all legal moves given a board configuration.
+         * @param board The board configuration for which legal moves will be generated.
+         * @param moves The list to fill with the legal moves, cleared first.
+        */
+        void GenerateLegalMoves(const std::shared_ptr<Board> &board, MoveList &moves) const { AttackInfo info; UpdateAttackInfo(board, info); GenerateLegalMoves(board, info, moves); };
+        /**
+         * @brief As GenerateLegalMoves but reusing attack information already worked out for the board.
+         * @param board The board configuration for which legal moves will be generated.
+         * @param info The attack information of the board from UpdateAttackInfo.
+         * @param moves The list to fill with the legal moves, cleared first.
+        */
+        void GenerateLegalMoves(const std::shared_ptr<Board> &board, const AttackInfo &info, MoveList &moves) const;
+        /**
+         * @brief Generate all legal moves given a board configuration. Moves are stored in fLegalMoves for the GUI and bindings, so unlike the other overload this is not safe to share between threads.
          * @param board The board configuration for which legal moves will be generated.
         */
-        void GenerateLegalMoves(const std::shared_ptr<Board> &board);
+        void GenerateLegalMoves(const std::shared_ptr<Board> &board) { GenerateLegalMoves(board, fLegalMoves); };
         /**
          * @brief Generates all legal moves involving a capture in the current position.
          * @param board The board configuration to generate moves for.
+         * @param moves The list to fill with the legal captures, cleared first.
         */
-        void GenerateCaptureMoves(const std::shared_ptr<Board> &board);
+        void GenerateCaptureMoves(const std::shared_ptr<Board> &board, MoveList &moves) const { AttackInfo info; UpdateAttackInfo(board, info); GenerateCaptureMoves(board, info, moves); };
         /**
-         * @brief Get the legal moves from the last move generation.
-         * @return Reference to the fLegalMoves vector.
+         * @brief As GenerateCaptureMoves but reusing attack information already worked out for the board.
+         * @param board The board configuration to generate moves for.
+         * @param info The attack information of the board from UpdateAttackInfo.
+         * @param moves The list to fill, cleared first.
         */
-        std::vector<U16> GetLegalMoves() { return fLegalMoves; };
+        void GenerateCaptureMoves(const std::shared_ptr<Board> &board, const AttackInfo &info, MoveList &moves) const;
         /**
-         * @brief Get a reference to the vector of legal moves stored [warning: dangerous do not modify in place]
-         * @return The legal moves vector.
+         * @brief Generates all legal moves that do not capture, including castling and quiet promotions. Together with
+         * GenerateCaptureMoves this gives every legal move.
+         * @param board The board configuration to generate moves for.
+         * @param moves The list to fill with the legal non-captures, cleared first.
         */
-        std::vector<U16>& GetLegalMoveRef() { return fLegalMoves; };
+        void GenerateQuietMoves(const std::shared_ptr<Board> &board, MoveList &moves) const { AttackInfo info; UpdateAttackInfo(board, info); GenerateQuietMoves(board, info, moves); };
         /**
-         * @brief Get the number of legal moves from the last move generation.
-         * @return Number of legal moves. 
+         * @brief As GenerateQuietMoves but reusing attack information already worked out for the board.
+         * @param board The board configuration to generate moves for.
+         * @param info The attack information of the board from UpdateAttackInfo.
+         * @param moves The list to fill, cleared first.
         */
-        U8 GetNLegalMoves() { return fLegalMoves.size(); };
+        void GenerateQuietMoves(const std::shared_ptr<Board> &board, const AttackInfo &info, MoveList &moves) const;
         /**
-         * @brief Get the number of legal capturing moves from last capture move generation.
-         * @return Number of capture moves. 
+         * @brief Generates the legal moves out of check: king moves, captures of a single checker and moves onto the squares
+         * between it and the king. Only valid when the colour to move is in check.
+         * @param board The board configuration to generate moves for.
+         * @param moves The list to fill with the evasions, cleared first. Left empty when not in check.
         */
-        U8 GetNCaptureMoves() { return fCaptureMoves.size(); };
+        void GenerateEvasionMoves(const std::shared_ptr<Board> &board, MoveList &moves) const { AttackInfo info; UpdateAttackInfo(board, info); GenerateEvasionMoves(board, info, moves); };
         /**
-         * @brief Get the move at the specified position from the legal moves vector.
+         * @brief As GenerateEvasionMoves but reusing attack information already worked out for the board.
+         * @param board The board configuration to generate moves for.
+         * @param info The attack information of the board from UpdateAttackInfo.
+         * @param moves The list to fill, cleared first.
+        */
+        void GenerateEvasionMoves(const std::shared_ptr<Board> &board, const AttackInfo &info, MoveList &moves) const;
+        /**
+         * @brief Generates the legal non-captures that give check, directly or by discovery. Castling and promotions are not
+         * included. Only valid when the colour to move is not in check.
+         * @param board The board configuration to generate moves for.
+         * @param moves The list to fill with the quiet checks, cleared first. Left empty when in check.
+        */
+        void GenerateQuietCheckMoves(const std::shared_ptr<Board> &board, MoveList &moves) const { AttackInfo info; UpdateAttackInfo(board, info); GenerateQuietCheckMoves(board, info, moves); };
+        /**
+         * @brief As GenerateQuietCheckMoves but reusing attack information already worked out for the board.
+         * @param board The board configuration to generate moves for.
+         * @param info The attack information of the board from UpdateAttackInfo.
+         * @param moves The list to fill, cleared first.
+        */
+        void GenerateQuietCheckMoves(const std::shared_ptr<Board> &board, const AttackInfo &info, MoveList &moves) const;
+        /**
+         * @brief Work out the checkers, pins and enemy attacks of the position, to be reused by every generation call and
+         * other query made at the same node.
+         * @param board The board configuration to inspect.
+         * @param info The attack information to fill.
+        */
+        void UpdateAttackInfo(const std::shared_ptr<Board> &board, AttackInfo &info) const;
+        /**
+         * @brief Get every piece of either colour attacking a square, with sliding rays blocked by the given occupancy.
+         * Pins are ignored.
+         * @param board The board configuration to inspect.
+         * @param square The LSB of the attacked square.
+         * @param occupancy The occupancy that blocks sliding pieces, pieces outside it are treated as already captured.
+         * @return Bitboard of the attacking pieces.
+        */
+        U64 GetAttackersTo(const std::shared_ptr<Board> &board, const U8 square, const U64 occupancy) const;
+        /**
+         * @brief Static exchange evaluation of a move: the material the mover expects to gain if both sides keep recapturing
+         * on the target square with their least valuable piece, either side free to stop when it would lose more.
+         * @param board The board the move is to be made on.
+         * @param move The move to evaluate, usually a capture.
+         * @return The material balance of the exchange in centipawns for the side making the move, negative if it loses material.
+        */
+        int GetStaticExchange(const std::shared_ptr<Board> &board, const U16 move) const;
+        /**
+         * @brief Get whether a move could have been generated in this position, ignoring only whether it exposes its own
+         * king. Works from the move word alone in constant time, so a move from elsewhere, such as a killer, can be tried
+         * without generating every move. Castling is checked in full and when in check the move must be an evasion.
+         * @param board The board the move is to be made on.
+         * @param info The attack information of the board from UpdateAttackInfo.
+         * @param move The move to check, including its type flag.
+         * @return True if the move is pseudo-legal.
+        */
+        bool IsPseudoLegal(const std::shared_ptr<Board> &board, const AttackInfo &info, const U16 move) const;
+        /**
+         * @brief Get whether a pseudo-legal move keeps its own king out of check. Only king moves, pinned pieces and
+         * en-passant need any work. Together with IsPseudoLegal this accepts exactly the moves GenerateLegalMoves produces.
+         * @param board The board the move is to be made on.
+         * @param info The attack information of the board from UpdateAttackInfo.
+         * @param move The move to check, must have passed IsPseudoLegal.
+         * @return True if the move is legal.
+        */
+        bool IsLegal(const std::shared_ptr<Board> &board, const AttackInfo &info, const U16 move) const;
+        /**
+         * @brief Work out the squares each type of piece of the colour to move would check the enemy king from, and the
+         * pieces that would discover check by moving. Done once per node to answer GivesCheck for any of its moves.
+         * @param board The board configuration to inspect.
+         * @param info The attack information of the board from UpdateAttackInfo.
+         * @param checkInfo The check information to fill.
+        */
+        void UpdateCheckInfo(const std::shared_ptr<Board> &board, const AttackInfo &info, CheckInfo &checkInfo) const;
+        /**
+         * @brief Get whether a legal move gives check, directly or by discovery, without making it. Castling, en-passant and
+         * promotions are worked out in full, everything else is a lookup in the check information.
+         * @param board The board the move is to be made on.
+         * @param checkInfo The check information of the board from UpdateCheckInfo.
+         * @param move The move to test.
+         * @return True if the enemy king is in check once the move is made.
+        */
+        bool GivesCheck(const std::shared_ptr<Board> &board, const CheckInfo &checkInfo, const U16 move) const;
+        /**
+         * @brief Get whether the king of the colour to move is attacked. Use AttackInfo::checkers instead where the attack
+         * information is already known.
+         * @param board The board configuration to check.
+         * @return True if the colour to move is in check.
+        */
+        bool IsInCheck(const std::shared_ptr<Board> &board) const;
+        /**
+         * @brief Get the legal moves from the last call to GenerateLegalMoves without a move list.
+         * @return Reference to the fLegalMoves list.
+        */
+        const MoveList& GetLegalMoves() const { return fLegalMoves; };
+        /**
+         * @brief Get the number of legal moves from the last move generation.
+         * @return Number of legal moves. 
+        */
+        U8 GetNLegalMoves() { return fLegalMoves.GetSize(); };
+        /**
+         * @brief Get the move at the specified position from the legal moves list.
          * @param index The index to copy the move from.
          * @return The move at the specified index.
         */
-        U16 GetMoveAt(const U8 index) { return index < fLegalMoves.size() ? fLegalMoves.at(index) : 0; };
+        U16 GetMoveAt(const U8 index) { return index < fLegalMoves.GetSize() ? fLegalMoves[index] : 0; };
         /**
          * @brief Get whether a provided move is legal. Will update the move word with extra information.
          * @param move The move to check.
@@ -76,184 +238,264 @@ class Generator {
          * @param board The board configuration to generate moves for.
          * @return True if any of the squares in mask are under attack from the specified colour.
         */
-        bool IsUnderAttack(const U64 mask, const Color attackingColor, const std::shared_ptr<Board> &board);
+        bool IsUnderAttack(const U64 mask, const Color attackingColor, const std::shared_ptr<Board> &board) const;
         /**
          * @brief Find the attacks of the pawns for a particular colour. To be used for move ordering.
          * @param board The board configuration.
          * @param colorToMoveAttacks True if the attacking colour is the current colour to move on board.
          * @return Mask of all possible attacks of pawns from the specified colour.
         */
-        U64 GetPawnAttacks(const std::shared_ptr<Board> &board, bool colorToMoveAttacks);
-        /**
-         * @brief Get all moves that are captures in the current set of legal moves.
-         * @return Vector of legal capture moves.
-        */
-        std::vector<U16> GetCaptureMoves() { return fCaptureMoves; };
+        U64 GetPawnAttacks(const std::shared_ptr<Board> &board, bool colorToMoveAttacks) const;
     private:
-        std::vector<U16> fLegalMoves; ///< The set of legal moves available upon the last call to GenerateLegalMoves.
-        std::vector<U16> fCaptureMoves; ///< The legal capturing moves available. Updated on call to GenerateLegalMoves.
-        /**
-         * @brief Generate attack tables for faster lookup during move generation.
-        */
-        void GenerateAttackTables();
-        /**
-         * @brief Fill the king attack table for the position specified.
-         * @param pos The position of the king.
-        */
-        void FillKingAttackTable(const U64 pos);
-        /**
-         * @brief Fill the knight attack table for the position specified.
-         * @param pos The position of the knight.
-        */
-        void FillKnightAttackTable(const U64 pos);
-        /**
-         * @brief Fill the attack tables for white and black pawns.
-         * @param pos The position of the pawn.
-        */
-        void FillPawnAttackTable(const U64 pos);
-        /**
-         * @brief Fill attack table for straight sliding rays. Fills the primary (up-down) and secondary (side-to-side) straight attacks (e.g. those of a rook).
-         * @param pos The position of the sliding piece (rook/queen).
-        */
-        void FillStraightAttackTables(const U64 pos);
+        MoveList fLegalMoves; ///< The set of legal moves available upon the last call to GenerateLegalMoves without a move list.
         /**
-         * @brief Fill attack table for diagonal sliding rays. Fills the primary and secondary diagonal attacks (e.g. those of a bishop).
-         * @param pos The position of the sliding piece (bishop/queen).
+         * @brief Check the board for a draw by the 50-move rule, insufficient material or repetition, setting its state if so.
+         * @param board The board to check.
+         * @return True if the game is drawn and no moves should be generated.
         */
-        void FillDiagonalAttackTables(const U64 pos);
+        bool CheckDraw(const std::shared_ptr<Board> &board) const;
         /**
          * @brief Check if the board has met the conditions for draw by the 50-move rule.
          * @param board The board to check.
          * @return True if the fifty move rule conditions have been met.
         */
-        bool CheckFiftyMoveDraw(const std::shared_ptr<Board> &board);
+        bool CheckFiftyMoveDraw(const std::shared_ptr<Board> &board) const;
         /**
          * @brief Check if the board has met the conditions for a draw by insufficient material.
          * @param board The board to check.
          * @return True if the conditions for insufficient material have been met.
         */
-        bool CheckInsufficientMaterial(const std::shared_ptr<Board> &board);
+        bool CheckInsufficientMaterial(const std::shared_ptr<Board> &board) const;
         /**
          * @brief Check if the board has met the conditions for a draw by move repitition.
          * @param board The board to check.
          * @return True if the board has reached the identically same position 3 times already.
         */
-        bool CheckMoveRepitition(const std::shared_ptr<Board> &board);
+        bool CheckMoveRepitition(const std::shared_ptr<Board> &board) const;
         /**
-         * @brief Generate the pseudo-legal moves for a given position and append to the fLegalMoves vector.
+         * @brief Generate moves of the given type for the colour to move, dispatching once on that colour so everything
+         * below runs as code specialised for one side.
+         * @tparam T Which moves to generate.
          * @param board The board configuration to generate moves for.
+         * @param state The attack information of the board from UpdateAttackInfo.
+         * @param moves The list to append to.
         */
-        void GeneratePseudoLegalMoves(const std::shared_ptr<Board> &board);
+        template<MoveGenType T>
+        void Generate(const std::shared_ptr<Board> &board, const AttackInfo &state, MoveList &moves) const;
         /**
-         * @brief Generate the pseudo-legal capturing moves for a given position and append to the fLegalMoves vector.
+         * @brief Generate moves of the given type for colour C.
+         * @tparam C The colour to move.
+         * @tparam T Which moves to generate.
          * @param board The board configuration to generate moves for.
+         * @param state The attack information of the board from UpdateAttackInfo.
+         * @param moves The list to append to.
         */
-        void GeneratePseudoLegalCaptureMoves(const std::shared_ptr<Board> &board);
+        template<Color C, MoveGenType T>
+        void GenerateMoves(const std::shared_ptr<Board> &board, const AttackInfo &state, MoveList &moves) const;
         /**
-         * @brief Generate the en-passant moves and append to fCaptureMoves
+         * @brief Work out the attack information: the pieces to move, the pieces giving check, the squares a non-king
+         * move must land on to resolve check, the absolutely pinned pieces and the squares attacked by the enemy.
+         * @tparam C The colour to move.
          * @param board The board configuration to generate moves for.
+         * @param state The attack information to fill.
         */
-        void GenerateEnPassantCaptureMoves(const std::shared_ptr<Board> &board);
+        template<Color C>
+        void UpdateAttackInfo(const std::shared_ptr<Board> &board, AttackInfo &state) const;
         /**
-         * @brief Remove illegal capturing moves (i.e. absolute pins, etc)
-         * @param board The board configuration to generate moves for.
+         * @brief Get whether a move of colour C is pseudo-legal, see the public overload.
+         * @tparam C The colour to move.
+         * @param board The board the move is to be made on.
+         * @param state The attack information of the board from UpdateAttackInfo.
+         * @param move The move to check.
+         * @return True if the move is pseudo-legal.
         */
-        void RemoveIllegalCaptureMoves(const std::shared_ptr<Board> &board); // TODO: These appened to fLegalMoves
+        template<Color C>
+        bool IsPseudoLegal(const std::shared_ptr<Board> &board, const AttackInfo &state, const U16 move) const;
         /**
-         * @brief Generate the pseudo-legal moves for the king.
+         * @brief Generate the legal moves out of check for colour C.
+         * @tparam C The colour to move.
          * @param board The board configuration to generate moves for.
+         * @param state The attack information of the position from UpdateAttackInfo, in check.
+         * @param moves The list to append to.
         */
-        void GenerateKingPseudoLegalMoves();
+        template<Color C>
+        void GenerateEvasions(const std::shared_ptr<Board> &board, const AttackInfo &state, MoveList &moves) const;
         /**
-         * @brief Generate the pseudo-legal moves for all the knights.
+         * @brief Fill the check squares and discovered check candidates of colour C against the enemy king.
+         * @tparam C The colour to move.
          * @param board The board configuration to generate moves for.
+         * @param state The attack information of the position from UpdateAttackInfo.
+         * @param info The check information to fill.
         */
-        void GenerateKnightPseudoLegalMoves(const std::shared_ptr<Board> &board);
+        template<Color C>
+        void UpdateCheckInfo(const std::shared_ptr<Board> &board, const AttackInfo &state, CheckInfo &info) const;
         /**
-         * @brief Generate the pseudo-legal moves for all the rooks.
+         * @brief Generate the non-captures of colour C that give check, excluding castling and promotions.
+         * @tparam C The colour to move.
          * @param board The board configuration to generate moves for.
+         * @param state The attack information of the position from UpdateAttackInfo, not in check.
+         * @param moves The list to append to.
         */
-        void GenerateRookPseudoLegalMoves(const std::shared_ptr<Board> &board);
+        template<Color C>
+        void GenerateQuietChecks(const std::shared_ptr<Board> &board, const AttackInfo &state, MoveList &moves) const;
         /**
-         * @brief Generate the pseudo-legal moves for all the bishops.
+         * @brief Generate the quiet checks of all the knights, bishops, rooks or queens of one colour.
+         * @tparam C The colour to move.
+         * @tparam P The type of piece, any but pawn and king.
          * @param board The board configuration to generate moves for.
+         * @param state The attack information of the position from UpdateAttackInfo.
+         * @param info The check information from UpdateCheckInfo.
+         * @param moves The list to append to.
+        */
+        template<Color C, Piece P>
+        void GeneratePieceTypeQuietChecks(const std::shared_ptr<Board> &board, const AttackInfo &state, const CheckInfo &info, MoveList &moves) const;
+        /**
+         * @brief Get the squares a piece may move to and give check: its check squares, or anywhere off its line to the enemy
+         * king when moving it discovers check.
+         * @param info The check information from UpdateCheckInfo.
+         * @param checkSquares The check squares of the piece's type.
+         * @param lsb The LSB of the piece.
+         * @return Bitboard of the squares giving check.
+        */
+        static U64 GetCheckingTargets(const CheckInfo &info, const U64 checkSquares, const U8 lsb) {
+            return (info.discoveryCandidates & (1ULL << lsb)) ? checkSquares | ~ATTACK_TABLES.line[info.enemyKingLSB][lsb] : checkSquares;
+        };
+        /**
+         * @brief Generate the legal moves of every piece landing on the target squares. Does not include castling or en-passant.
+         * @tparam C The colour to move.
+         * @param board The board configuration to generate moves for.
+         * @param state The attack information of the position from UpdateAttackInfo.
+         * @param targets Squares moves may land on, everything not occupied by our own pieces for all moves or the enemy pieces for captures.
+         * @param moves The list to append to.
+        */
+        template<Color C>
+        void GeneratePieceMoves(const std::shared_ptr<Board> &board, const AttackInfo &state, const U64 targets, MoveList &moves) const;
+        /**
+         * @brief Generate the legal moves for the king, never onto a square attacked by the enemy.
+         * @param state The attack information of the position from UpdateAttackInfo.
+         * @param targets Squares the king may land on.
+         * @param moves The list to append to.
         */
-        void GenerateBishopPseudoLegalMoves(const std::shared_ptr<Board> &board);
+        void GenerateKingMoves(const AttackInfo &state, const U64 targets, MoveList &moves) const;
         /**
-         * @brief Generate the pseudo-legal moves for all the queens.
+         * @brief Generate the legal moves for all the knights, bishops, rooks or queens of one colour.
+         * @tparam C The colour to move.
+         * @tparam P The type of piece, any but pawn and king.
          * @param board The board configuration to generate moves for.
+         * @param state The attack information of the position from UpdateAttackInfo.
+         * @param targets Squares the pieces may land on, already restricted to those resolving any check.
+         * @param moves The list to append to.
         */
-        void GenerateQueenPseudoLegalMoves(const std::shared_ptr<Board> &board);
+        template<Color C, Piece P>
+        void GeneratePieceTypeMoves(const std::shared_ptr<Board> &board, const AttackInfo &state, const U64 targets, MoveList &moves) const;
         /**
-         * @brief Generate the pseudo-legal moves for all the pawns.
+         * @brief Generate the legal moves for all the pawns, excluding en-passant.
+         * @tparam C The colour to move.
          * @param board The board configuration to generate moves for.
+         * @param state The attack information of the position from UpdateAttackInfo.
+         * @param targets Squares the pawns may land on, already restricted to those resolving any check.
+         * @param moves The list to append to.
         */
-        void GeneratePawnPseudoLegalMoves(const std::shared_ptr<Board> &board);
+        template<Color C>
+        void GeneratePawnMoves(const std::shared_ptr<Board> &board, const AttackInfo &state, const U64 targets, MoveList &moves) const;
         /**
-         * @brief Generate en-passant moves.
+         * @brief Generate legal en-passant moves.
+         * @tparam C The colour to move.
          * @param board The board configuration to generate moves for.
+         * @param state The attack information of the position from UpdateAttackInfo.
+         * @param moves The list to append to.
         */
-        void GenerateEnPassantMoves(const std::shared_ptr<Board> &board);
+        template<Color C>
+        void GenerateEnPassantMoves(const std::shared_ptr<Board> &board, const AttackInfo &state, MoveList &moves) const;
+        /**
+         * @brief Get whether taking en-passant leaves the king safe. Both pawns leave the rank at once, so the pin masks
+         * miss some exposed checks and the position after the capture is tested directly.
+         * @tparam C The colour to move.
+         * @param board The board configuration.
+         * @param state The attack information of the position from UpdateAttackInfo.
+         * @param pawn The position of the capturing pawn.
+         * @param target The en-passant square.
+         * @return True if no enemy slider sees the king once the capture is made.
+        */
+        template<Color C>
+        static bool GetEnPassantIsLegal(const std::shared_ptr<Board> &board, const AttackInfo &state, const U64 pawn, const U64 target);
         /**
          * @brief Generate the set of possible castling moves.
+         * @tparam C The colour to move.
          * @param board The board configuration to generate moves for.
+         * @param state The attack information of the position from UpdateAttackInfo.
+         * @param moves The list to append to.
         */
-        void GenerateCastlingMoves(const std::shared_ptr<Board> &board);
+        template<Color C>
+        void GenerateCastlingMoves(const std::shared_ptr<Board> &board, const AttackInfo &state, MoveList &moves) const;
         /**
          * @brief Get whether a specific type of castling is possible. Effectively checks occupancy and attack masks.
-         * @param castlingMask All squares that must be free from attack in order to permit castling (includes the king and end point and all squares in between).
+         * @param state The attack information of the position from UpdateAttackInfo.
+         * @param castlingMask All squares the king passes through and lands on, which must be free from attack.
          * @param occupanyMask The tiles that must be free of any occupancy in order for castling to be permitted.
-         * @param board The board configuration to generate moves for.
          * @return True if castling with these masks is possible.
         */
-        bool IsCastlingPossible(U64 castlingMask, U64 occupancyMask, const std::shared_ptr<Board> &board);
+        static bool IsCastlingPossible(const AttackInfo &state, U64 castlingMask, U64 occupancyMask);
+        /**
+         * @brief Append a move from the origin to each of the target squares.
+         * @param origin The position of the moving piece.
+         * @param targets The squares it moves to.
+         * @param flag The move type given to every move, e.g. MOVE_QUIET or MOVE_CAPTURE.
+         * @param moves The list to append to.
+        */
+        static void AddMoves(const U64 origin, U64 targets, const U16 flag, MoveList &moves);
+        /**
+         * @brief Append a pawn move to each of the target squares, one per promotion piece when reaching the last rank.
+         * @tparam C The colour of the pawn.
+         * @param pawn The position of the moving pawn.
+         * @param targets The squares it moves to.
+         * @param flag Either MOVE_QUIET or MOVE_CAPTURE, promotions keep the capture bit.
+         * @param moves The list to append to.
+        */
+        template<Color C>
+        static void AddPawnMoves(const U64 pawn, U64 targets, const U16 flag, MoveList &moves);
+        /**
+         * @brief Get the squares a piece may move to without exposing its own king.
+         * @param state The attack information of the position from UpdateAttackInfo.
+         * @param lsb The LSB of the piece.
+         * @return The pinning ray (including the pinning piece) if the piece is absolutely pinned, every square otherwise.
+        */
+        static U64 GetPinRay(const AttackInfo &state, const U8 lsb) { return (state.pinned & (1ULL << lsb)) ? state.pinRays[lsb] : ~0ULL; };
+        /**
+         * @brief Get the squares attacked by a knight, bishop, rook or queen.
+         * @tparam P The type of piece.
+         * @param lsb The LSB of the piece.
+         * @param occupancy The occupancy that blocks sliding pieces.
+         * @return Bitboard of attacked squares.
+        */
+        template<Piece P>
+        static U64 GetPieceAttacks(const U8 lsb, const U64 occupancy) {
+            if constexpr(P == Piece::Knight) {
+                return ATTACK_TABLES.knight[lsb];
+            } else if constexpr(P == Piece::Bishop) {
+                return GetBishopAttacks(lsb, occupancy);
+            } else if constexpr(P == Piece::Rook) {
+                return GetRookAttacks(lsb, occupancy);
+            } else {
+                return GetQueenAttacks(lsb, occupancy);
+            }
+        };
         /**
          * @brief Get the bitboard of all possible attacks by the specified colour assuming they are the next colour to move. Does not take into account absolutely positioned pieces.
          * @param board The board configuration to generate moves for.
          * @param attackingColor The colour to calculate attacks for (assumes they are colour to move).
          * @return Mask of all attacks by the attacking colour excluding absolute pins.
         */
-        U64 GetAttacks(const std::shared_ptr<Board> &board, const Color attackingColor);
+        U64 GetAttacks(const std::shared_ptr<Board> &board, const Color attackingColor) const;
         /**
-         * @brief Removes illegal moves from the fLegalMoves vector. Does a complete check such as with absolute pins etc.
-         * @param board The board configuration to generate moves for.
-        */
-        void RemoveIllegalMoves(const std::shared_ptr<Board> &board);
-        /**
-         * @brief Fill a vetor with the position of all absolutely pinned pieces and the pinning ray they occupy.
-         * @param board The board configuration to generate moves for.
-         * @param v Vector to fill.
-         * @param d Direction to search for pinning rays.
-        */
-        void AddAbolsutePins(const std::shared_ptr<Board> &board, Direction d);
-        /**
-         * @brief Remove moves from the fLegalMoves vector that do not resolve the check when the king is in check.
+         * @brief Get the bitboard of all possible attacks by colour C with sliding rays blocked by the given occupancy.
+         * @tparam C The colour to calculate attacks for.
          * @param board The board configuration to generate moves for.
+         * @param occupancy The occupancy that blocks sliding pieces.
+         * @return Mask of all attacks by the attacking colour excluding absolute pins.
         */
-        void PruneCheckMoves(const std::shared_ptr<Board> &board, const bool copyToCapures);
-
-        // Attack tables generated on instantiation
-        U64 fKnightAttacks[64]; ///< All possible attacks of a knight at each position on the board.
-        U64 fKingAttacks[64]; ///< All possible attacks of a king at each position on the board.
-        U64 fPrimaryDiagonalAttacks[64]; ///< Primary diagonal (bottom left to top right) attacks for a sliding diagonal piece at LSB.
-        U64 fSecondaryDiagonalAttacks[64]; ///< Secondary diagonal (top left to bottom right) attacks for a sliding diagonal piece at LSB.
-        U64 fPrimaryStraightAttacks[64]; ///< Primary straight attacks (rank) for a sliding straight piece at LSB.
-        U64 fSecondaryStraightAttacks[64]; ///< Primary straight attacks (file) for a sliding straight piece at LSB.
-        U64 fWhitePawnDiagonalAttacks[64]; ///< All possible diagonal attacks of a white pawn given LSB as input.
-        U64 fBlackPawnDiagonalAttacks[64]; ///< All possible diagonal attacks of a black pawn given LSB as input.
-        U64 fWhitePawnForwardAttacks[64]; ///< Attacks (1 and 2 square forwards) of the white pawns
-        U64 fBlackPawnForwardAttacks[64]; ///< Attacks (1 and 2 square forwards) of the black pawns
-
-        // Variables to use when generating moves, helps reduce number of function calls
-        Color fColor; ///< The colour of the piece to move for the provided board configuration when generating legal moves is called.
-        U64 fEnemy; ///< Occupancy bit board of the color not to move.
-        Color fOtherColor; ///< The colour who has just moved.
-        U64 fOccupancy; ///< Total occupancy of the board represented as a single bitboard for ray occupancy calculations.
-        U64 fKing; ///< Position of the king whose colour it is to move.
-
-        std::vector<std::pair<U64, U64>> fPinnedPieces; ///< The position of the absolutely pinned piece and the ray pinning it including the position of the pinning piece.
-        U64 fPinnedPositions; ///< Accumulation of first elements of fPinnedPieces.
-
+        template<Color C>
+        U64 GetAttacks(const std::shared_ptr<Board> &board, const U64 occupancy) const;
 };
 
 #endif
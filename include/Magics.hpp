@@ -0,0 +1,77 @@
+/**
+ * @file Magics.hpp
+ * @brief Fancy magic bitboard lookup of sliding piece attacks.
+ */
+
+#ifndef MAGICS_HPP
+#define MAGICS_HPP
+
+#include "Constants.hpp"
+
+extern bool SLIDERS_USE_PEXT; ///< Index the attack tables with PEXT rather than the magic multiply, chosen once by InitMagics.
+
+/**
+ * @brief Magic lookup entry for a single square. Any occupancy is mapped to that square's slice of the attack table with one
+ * mask, one multiply and one shift, or a single PEXT on CPUs with fast BMI2.
+*/
+struct Magic {
+    U64 mask; ///< Squares whose occupancy affects the attacks, the rays from the square excluding the board edges.
+    U64 magic; ///< Multiplier mapping every subset of mask to a distinct (or constructively colliding) index.
+    U64 *attacks; ///< Start of this square's slice of the shared attack table.
+    unsigned int shift; ///< 64 minus the number of set bits in mask.
+
+    /**
+     * @brief Get the index into attacks for the given board occupancy.
+     * @param occupancy The occupancy of the whole board.
+     * @return Index of the attack set in this square's slice of the table.
+    */
+    unsigned int GetIndex(const U64 occupancy) const {
+        if(SLIDERS_USE_PEXT)
+            return (unsigned int)ParallelExtract(occupancy, mask);
+        return (unsigned int)(((occupancy & mask) * magic) >> shift);
+    };
+};
+
+extern Magic ROOK_MAGICS[NSQUARES]; ///< Rook magic lookup entries indexed by LSB, filled by InitMagics.
+extern Magic BISHOP_MAGICS[NSQUARES]; ///< Bishop magic lookup entries indexed by LSB, filled by InitMagics.
+
+/**
+ * @brief Detect the CPU features, then fill the rook and bishop attack tables indexed by PEXT when BMI2 is available or by
+ * magic numbers otherwise. The tables are shared by the whole process and only built on the first call, so this is cheap
+ * to call from every Generator constructor.
+*/
+void InitMagics();
+
+/**
+ * @brief Get the squares attacked by a rook, stopping at (and including) the first occupied square on each ray.
+ * @param square The LSB of the rook.
+ * @param occupancy The occupancy of the whole board.
+ * @return Bitboard of attacked squares.
+*/
+inline U64 GetRookAttacks(const int square, const U64 occupancy) {
+    const Magic &m = ROOK_MAGICS[square];
+    return m.attacks[m.GetIndex(occupancy)];
+}
+
+/**
+ * @brief Get the squares attacked by a bishop, stopping at (and including) the first occupied square on each ray.
+ * @param square The LSB of the bishop.
+ * @param occupancy The occupancy of the whole board.
+ * @return Bitboard of attacked squares.
+*/
+inline U64 GetBishopAttacks(const int square, const U64 occupancy) {
+    const Magic &m = BISHOP_MAGICS[square];
+    return m.attacks[m.GetIndex(occupancy)];
+}
+
+/**
+ * @brief Get the squares attacked by a queen, the union of the rook and bishop attacks.
+ * @param square The LSB of the queen.
+ * @param occupancy The occupancy of the whole board.
+ * @return Bitboard of attacked squares.
+*/
+inline U64 GetQueenAttacks(const int square, const U64 occupancy) {
+    return GetRookAttacks(square, occupancy) | GetBishopAttacks(square, occupancy);
+}
+
+#endif
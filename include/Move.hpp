@@ -8,16 +8,30 @@
 
 #include "Constants.hpp"
 
-// A move is fully described by a 16-bit word. The first 6 bits specify the start tile, the next 6 the end tile then the file 4 bits
-// act as flags for special things such as pawn promotion (last bit set if is castling, other 3 specify promotion piece type)
+// A move is fully described by a 16-bit word. The first 6 bits specify the start tile, the next 6 the end tile then the final 4 bits
+// give the type of move so making it never has to work out from the board what kind of move it is
 // E.g. move = FFFFEEEEEESSSSSS
 // The 6-bit numbers are the least significant set bit in the position.
+// Of the flag bits, bit 14 is set for any capture and bit 15 for any promotion. For promotions the two lowest flag bits
+// give the promotion piece (offset from the bishop), otherwise they tell apart the kinds of quiet move and capture.
 
 // Define constants for bit positions
 constexpr U16 ORIGIN_MASK = 0b111111; ///< Bits [0,5] used to provide the LSB of the move origin.
 constexpr U16 TARGET_MASK = 0b111111 << 6; ///< Bits [6,11] used to provide the LSB of the move target.
-constexpr U16 PROMOTION_MASK = 0b111 << 12; ///< Bits [12,14] represent the type of piece the pawn promotes to, if no promotion null piece is used
-constexpr U16 ISCASTLING_MASK = 0b1 << 15;
+constexpr U16 FLAG_MASK = 0b1111 << 12; ///< Bits [12,15] hold the move type flag.
+constexpr U16 CAPTURE_MASK = 0b0100 << 12; ///< Set for every move that takes a piece, including en-passant.
+constexpr U16 PROMOTION_MASK = 0b1000 << 12; ///< Set for every pawn promotion.
+constexpr U16 PROMOTION_PIECE_MASK = 0b0011 << 12; ///< For promotions, the piece promoted to as an offset from Piece::Bishop.
+
+// Move type flags, already shifted into bits [12,15]
+constexpr U16 MOVE_QUIET = 0b0000 << 12;
+constexpr U16 MOVE_DOUBLE_PUSH = 0b0001 << 12;
+constexpr U16 MOVE_KING_CASTLE = 0b0010 << 12;
+constexpr U16 MOVE_QUEEN_CASTLE = 0b0011 << 12;
+constexpr U16 MOVE_CAPTURE = 0b0100 << 12;
+constexpr U16 MOVE_EN_PASSANT = 0b0101 << 12;
+constexpr U16 MOVE_PROMOTION = 0b1000 << 12;
+constexpr U16 MOVE_PROMOTION_CAPTURE = 0b1100 << 12;
 
 /**
  * @brief Get the bitboard with a single set bit at the origin of the move.
@@ -60,12 +74,39 @@ inline void SetMoveTarget(U16 &move, U64 origin) {
     move |= ((lsb & 0b111111) << 6); // Set bits [6,11] based on the new value
 }
 
-inline bool GetMoveIsCastling(U16 move) {
-    return move & ISCASTLING_MASK;
+/**
+ * @brief Get the move type flag, one of the MOVE_ constants, with the promotion piece bits included for promotions.
+ * @param move The 16-bit move word.
+ * @return The flag bits [12,15] of the move, left in place.
+*/
+inline U16 GetMoveFlag(U16 move) {
+    return move & FLAG_MASK;
+}
+
+/**
+ * @brief Set the move type flag.
+ * @param move The 16-bit move word to modify in-place.
+ * @param flag One of the MOVE_ constants.
+*/
+inline void SetMoveFlag(U16 &move, U16 flag) {
+    move &= ~FLAG_MASK;
+    move |= flag & FLAG_MASK;
+}
+
+inline bool GetMoveIsCapture(U16 move) {
+    return move & CAPTURE_MASK;
 }
 
-inline void SetMoveIsCastling(U16 &move, bool isCastling) {
-    isCastling ? move |= ISCASTLING_MASK : move &= ~ISCASTLING_MASK;
+inline bool GetMoveIsEnPassant(U16 move) {
+    return GetMoveFlag(move) == MOVE_EN_PASSANT;
+}
+
+inline bool GetMoveIsDoublePush(U16 move) {
+    return GetMoveFlag(move) == MOVE_DOUBLE_PUSH;
+}
+
+inline bool GetMoveIsCastling(U16 move) {
+    return (GetMoveFlag(move) & ~(0b0001 << 12)) == MOVE_KING_CASTLE; // Matches both king and queen side
 }
 
 inline bool GetMoveIsPromotion(U16 move) {
@@ -73,25 +114,31 @@ inline bool GetMoveIsPromotion(U16 move) {
 }
 
 inline Piece GetMovePromotionPiece(U16 move) {
-    U8 numPiece = (move & PROMOTION_MASK) >> 12;
-    Piece piece = Piece::Null;
-    if(numPiece < 7)
-        piece = static_cast<Piece>(numPiece);
-    return piece;
+    if(!GetMoveIsPromotion(move))
+        return Piece::Null;
+    return static_cast<Piece>(((move & PROMOTION_PIECE_MASK) >> 12) + (int)Piece::Bishop);
 }
 
+/**
+ * @brief Mark the move as a promotion to the given piece, keeping whether it is a capture.
+ * @param move The 16-bit move word to modify in-place.
+ * @param piece The piece to promote to, one of bishop, knight, rook or queen.
+*/
 inline void SetMovePromotionPiece(U16 &move, Piece piece) {
-    U8 numPiece = static_cast<int>(piece);
-    move &= ~PROMOTION_MASK; // Clear the bits
-    move |= ((numPiece & 0b111) << 12); // Set the new bits
+    move &= ~PROMOTION_PIECE_MASK; // Clear the bits
+    move |= PROMOTION_MASK | ((((int)piece - (int)Piece::Bishop) & 0b11) << 12); // Set the new bits
 }
 
-
 inline void SetMove(U16 &move, U64 origin, U64 target) {
     SetMoveOrigin(move, origin);
     SetMoveTarget(move, target);
 }
 
+inline void SetMove(U16 &move, U64 origin, U64 target, U16 flag) {
+    SetMove(move, origin, target);
+    SetMoveFlag(move, flag);
+}
+
 inline void PrintMove(U16 m) {
     std::cout << GetStringPosition(GetMoveOrigin(m)) << GetStringPosition(GetMoveTarget(m));
     if(GetMoveIsPromotion(m)) {
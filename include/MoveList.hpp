@@ -0,0 +1,101 @@
+/**
+ * @file MoveList.hpp
+ * @brief Definition of the MoveList class.
+ */
+
+#ifndef MOVELIST_HPP
+#define MOVELIST_HPP
+
+#include "Constants.hpp"
+
+/**
+ * @class MoveList
+ * @brief Fixed capacity list of moves with an ordering score per move.
+ *
+ * Lives on the stack of whoever asks for moves so generating and searching a node never touches the heap. Holds up to
+ * MAX_MOVES moves, no bounds checking is done when adding.
+ */
+class MoveList {
+    public:
+        /**
+         * @brief Instantiate an empty move list. The storage is left uninitialised.
+        */
+        MoveList() : fSize(0) {};
+        /**
+         * @brief Append a move to the end of the list with a score of zero.
+         * @param move The move to add.
+        */
+        void Add(const U16 move) { fScores[fSize] = 0; fMoves[fSize++] = move; };
+        /**
+         * @brief Remove every move from the list.
+        */
+        void Clear() { fSize = 0; };
+        /**
+         * @brief Get the number of moves in the list.
+         * @return Number of moves.
+        */
+        int GetSize() const { return fSize; };
+        /**
+         * @brief Get the move at the specified index.
+         * @param index Index of the move, must be less than GetSize().
+         * @return The move.
+        */
+        U16 operator[](const int index) const { return fMoves[index]; };
+        /**
+         * @brief Overwrite the move at the specified index, keeping its score.
+         * @param index Index of the move, must be less than GetSize().
+         * @param move The new move.
+        */
+        void SetMove(const int index, const U16 move) { fMoves[index] = move; };
+        /**
+         * @brief Get the ordering score of the move at the specified index.
+         * @param index Index of the move.
+         * @return Score of the move, higher is searched first.
+        */
+        int GetScore(const int index) const { return fScores[index]; };
+        /**
+         * @brief Set the ordering score of the move at the specified index.
+         * @param index Index of the move.
+         * @param score Score of the move, higher is searched first.
+        */
+        void SetScore(const int index, const int score) { fScores[index] = score; };
+        /**
+         * @brief Remove all moves for which the predicate returns true, keeping the order of the rest.
+         * @param predicate Callable taking a U16 move and returning true to remove it.
+        */
+        template <typename Predicate>
+        void RemoveIf(Predicate predicate) {
+            int kept = 0;
+            for(int i = 0; i < fSize; ++i) {
+                if(!predicate(fMoves[i])) {
+                    fMoves[kept] = fMoves[i];
+                    fScores[kept++] = fScores[i];
+                }
+            }
+            fSize = kept;
+        };
+        /**
+         * @brief Sort the moves by score, highest first. Insertion sort since lists are short, moves with equal scores keep their order.
+        */
+        void SortByScore() {
+            for(int i = 1; i < fSize; ++i) {
+                const U16 move = fMoves[i];
+                const int score = fScores[i];
+                int j = i - 1;
+                for(; j >= 0 && fScores[j] < score; --j) {
+                    fMoves[j + 1] = fMoves[j];
+                    fScores[j + 1] = fScores[j];
+                }
+                fMoves[j + 1] = move;
+                fScores[j + 1] = score;
+            }
+        };
+        const U16* begin() const { return fMoves; };
+        const U16* end() const { return fMoves + fSize; };
+    private:
+        U16 fMoves[MAX_MOVES]; ///< The moves, only the first fSize entries are valid.
+        int fScores[MAX_MOVES]; ///< Ordering score of each move in fMoves.
+        int fSize; ///< Number of moves in the list.
+};
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @file MovePicker.hpp
+ * @brief Definition of the MovePicker class.
+ */
+
+#ifndef MOVEPICKER_HPP
+#define MOVEPICKER_HPP
+
+#include <memory>
+
+#include "Constants.hpp"
+#include "Board.hpp"
+#include "Move.hpp"
+#include "MoveList.hpp"
+#include "Generator.hpp"
+
+/**
+ * @brief The stages a MovePicker works through, in order.
+*/
+enum class PickerStage {
+    GenerateEvasions, ///< In check, evasions not yet generated.
+    Evasions, ///< The moves out of check, best first. Replaces every other stage.
+    GenerateCaptures, ///< Captures not yet generated.
+    GoodCaptures, ///< Captures that don't lose material in the exchange that follows, best first.
+    Killers, ///< Quiet moves that caused a cut off in a sibling node, checked for legality without generating the quiet moves.
+    GenerateQuiets, ///< Quiet moves not yet generated.
+    Quiets, ///< The remaining quiet moves, those giving check moved forward.
+    BadCaptures, ///< Captures losing material by static exchange evaluation, left until last.
+    Done ///< No moves left.
+};
+
+/**
+ * @class MovePicker
+ * @brief Hands out the legal moves of a position one at a time, generating each group of moves only once the previous
+ * group has run out.
+ *
+ * Captures are generated first, so a node refuted by a capture never generates its quiet moves. In check only the evasions
+ * are generated, all at once, as there are few of them. Lives on the stack of
+ * the search node using it. The board and generator must not be left changed between calls to GetNextMove, moves made
+ * by deeper searches must be undone first.
+ */
+class MovePicker {
+    public:
+        /**
+         * @brief Instantiate a picker for the current position of the board.
+         * @param generator The generator to produce moves with.
+         * @param board The board to pick moves for.
+         * @param info The attack information of the board from Generator::UpdateAttackInfo, must outlive the picker.
+         * @param killers The two killer moves for this ply, either may be 0.
+        */
+        explicit MovePicker(const std::shared_ptr<Generator> &generator, const std::shared_ptr<Board> &board, const AttackInfo &info, const U16 killers[2]);
+        /**
+         * @brief Get the next move to search.
+         * @return The next legal move, or 0 once every move has been returned.
+        */
+        U16 GetNextMove();
+        /**
+         * @brief Get whether the last move returned by GetNextMove does not capture.
+         * @return True if the move came from the killer or quiet stages.
+        */
+        bool GetIsQuiet() const { return fStage == PickerStage::Killers || fStage == PickerStage::Quiets; };
+        /**
+         * @brief Score a move for ordering, higher scores are better. Captures of valuable pieces by cheap ones score highest
+         * (MVV-LVA), promotions are rewarded and moving onto a square attacked by an enemy pawn is penalised.
+         * @param board The board the move is to be made on.
+         * @param move The move to score.
+         * @param enemyPawnAttacks Squares attacked by the pawns of the side not to move.
+         * @return Score of the move in centipawns.
+        */
+        static int ScoreMove(const std::shared_ptr<Board> &board, const U16 move, const U64 enemyPawnAttacks);
+    private:
+        const std::shared_ptr<Generator> &fGenerator;
+        const std::shared_ptr<Board> &fBoard;
+        const AttackInfo &fInfo; ///< Attack information of the position, shared by every generation stage.
+        PickerStage fStage; ///< The stage the last move was returned from.
+        U16 fKillers[2]; ///< Killer moves for this ply, cleared if not legal here. Those left are taken out of the quiet moves so they are not repeated.
+        MoveList fCaptures; ///< Legal captures, or every evasion when in check, sorted best first. Bad captures are moved to the front as they are passed over.
+        MoveList fQuiets; ///< Legal quiet moves, sorted best first.
+        int fIndex; ///< Index of the next move to consider in the current list.
+        int fNBadCaptures; ///< Number of bad captures stored at the front of fCaptures.
+        /**
+         * @brief Score every move of the list with ScoreMove and sort them best first.
+         * @param moves The list to order.
+        */
+        void ScoreAndSort(MoveList &moves);
+        /**
+         * @brief Score the quiet moves as ScoreAndSort, moving those that give check ahead by QUIET_CHECK_BONUS, and sort them best first.
+        */
+        void ScoreAndSortQuiets();
+};
+
+#endif
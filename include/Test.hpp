@@ -28,6 +28,9 @@ class Test {
         /**
          * @brief Generate the number of moves possible up to the specified depth. Can compare with literature (fExpectedGeneration).
          *
+         * With bulk counting on (the default) the legal moves at depth 1 are counted without being made. Each move is only made
+         * and taken back at depth 1 in full mode, or when printing the moves found there.
+         *
          * If operating with useGUI on then each move will be made the GUI updated and the loop paused until the user enters N in the console ("next") thereby checking each moves validity slowly.
         */
         unsigned long int MoveGeneration(int depth);
@@ -47,6 +50,19 @@ class Test {
          * @brief Set the print depth for perft testing
         */
         void SetPrintDepth(int depth) { fPrintDepth = depth; };
+        /**
+         * @brief Choose whether perft counts the legal moves at depth 1 instead of making each of them. Full mode is slower but
+         * also exercises MakeMove and UndoMove on every leaf, useful when debugging the board.
+         * @param bulkCounting True to bulk count, false for full mode.
+        */
+        void SetBulkCounting(bool bulkCounting) { fBulkCounting = bulkCounting; };
+        /**
+         * @brief Run perft and a fixed depth engine search over a set of standard positions, printing the nodes per second of each.
+         * The search is run once with make/unmake and once with copy-make so the two can be compared.
+         * @param perftDepth The depth to run perft to for each position.
+         * @param searchDepth The maximum depth of the engine search for each position.
+        */
+        void Benchmark(int perftDepth, int searchDepth);
         /**
          * @brief Set whether to display the GUI
         */
@@ -54,10 +70,12 @@ class Test {
         bool fUseGUI; ///< If true display GUI to user when performing the tests
         int fPrintDepth;
         bool fDoFinePrint; ///< Print out all moves at depth 1 during perft testing
+        bool fBulkCounting; ///< Count the legal moves at depth 1 during perft rather than making each one
         std::shared_ptr<Board> fBoard;
         std::shared_ptr<Generator> fGenerator;
         std::shared_ptr<Renderer> fGUI;
         std::vector<unsigned long int> fExpectedGeneration; ///< Total number of possible moves after each depth level
+        std::vector<std::string> fBenchmarkPositions; ///< FEN strings of the positions used for benchmarking (empty string is the start position)
 };
 
 #endif
\ No newline at end of file
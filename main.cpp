@@ -11,7 +11,9 @@ bool ProcessCommandLineArgs(const std::vector<std::string>& args,
                             bool &doGame,
                             bool &helpRequested,
                             bool &doFinePrint,
+                            bool &perftFull,
                             int &perftDepth,
+                            int &benchDepth,
                             int &playSelf,
                             Color &userColor,
                             std::string &fenString,
@@ -22,6 +24,10 @@ bool ProcessCommandLineArgs(const std::vector<std::string>& args,
             useGUI = false;
         } else if(!arg.compare("--perft")) {
             perftDepth = std::stoi(args[i+1]); // TODO: Catch if this is not a valid digit
+        } else if(!arg.compare("--perft-full")) {
+            perftFull = true; ///< Make and undo every leaf move in perft instead of bulk counting the last ply
+        } else if(!arg.compare("--bench")) {
+            benchDepth = std::stoi(args[i+1]);
         } else if(!arg.compare("--verbose")) {
             doFinePrint = true; ///< Print all the moves generated when perft testing, useful for debugging
         } else if(!arg.compare("--help")) {
@@ -48,7 +54,9 @@ void DisplayHelp() {
               << "  A static evaluation based chess engine. You can play against the computer or get the best moves from given positions.\n\n"
               << "Options:\n"
               << "  --no-gui            Run the program without a graphical user interface.\n"
-              << "  --perft <depth>     Perform a perft test up to the specified depth. Depths >= 7 can take a significant time to compute depending on the positions complexity.\n"
+              << "  --perft <depth>     Perform a perft test up to the specified depth. Legal moves at the last ply are counted without being made.\n"
+              << "  --perft-full        Make and take back every leaf move when performing a perft test, slower but useful for debugging the board.\n"
+              << "  --bench <depth>     Report perft and search nodes per second over a set of standard positions. Perft runs to the given depth, search to --depth.\n"
               << "  --fen <fen>         Specify an initial position for the engine to perform perft tests or play against using the standard FEN notation.\n"
               << "  --play              Play a game of user versus the computer. The engine will play the best move.\n"
               << "  --play-self <n>     Make the computer play against itself n times and print the outcomes.\n"
@@ -90,7 +98,6 @@ void PlaySelf(int nGames, int depth, Color bestEngineColor) {
                 move = engine->GetRandomMove(); // other engine, for now, is the random agent
             }
             board->MakeMove(move);
-            board->AddCurrentHistory();
         }
 
         if(board->GetState() == State::Checkmate) {
@@ -129,21 +136,27 @@ int main(int argc, char* argv[]) {
     bool doGame = false;
     bool helpRequested = false;
     bool doFinePrint = false;
+    bool perftFull = false;
     int perftDepth = 0;
+    int benchDepth = 0;
     int maxDepth = 4;
     int playSelf = 0;
     Color userColor = Color::White;
     std::string fenString = "";
 
     std::vector<std::string> args(argv, argv + argc);
-    ProcessCommandLineArgs(args, useGUI, doGame, helpRequested, doFinePrint, perftDepth, playSelf, userColor, fenString, maxDepth);
+    ProcessCommandLineArgs(args, useGUI, doGame, helpRequested, doFinePrint, perftFull, perftDepth, benchDepth, playSelf, userColor, fenString, maxDepth);
 
     if(helpRequested) {
         DisplayHelp();
     } else if(perftDepth > 0) {
         Test myTest = Test(useGUI);
+        myTest.SetBulkCounting(!perftFull);
         unsigned long int result = myTest.GetNodes(perftDepth, fenString, doFinePrint);
         std::cout << "\nNodes searched: " << result << "\n";
+    } else if(benchDepth > 0) {
+        Test myTest = Test(useGUI);
+        myTest.Benchmark(benchDepth, maxDepth);
     } else if(doGame) {
         QApplication app(argc, argv);
         const std::shared_ptr<Board> board = std::make_unique<Board>(); // Initialize the main game board
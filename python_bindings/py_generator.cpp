@@ -99,12 +99,15 @@ PYBIND11_MODULE(chess_engine, m) {
         .def("print_fen", &Board::PrintFEN)
         .def("make_move", &Board::MakeMove)
         .def("undo_move", &Board::UndoMove)
-        .def("get_board_color_piece", py::overload_cast<const Color, const Piece>(&Board::GetBoard), "Get the bitboard for a particular piece type and colour.", py::arg("color"), py::arg("piece"));
+        .def("get_board_color_piece", py::overload_cast<const Color, const Piece>(&Board::GetBoard, py::const_), "Get the bitboard for a particular piece type and colour.", py::arg("color"), py::arg("piece"));
     
     py::class_<Generator>(m, "Generator")
         .def(py::init<>())
-        .def("generate_legal_moves", &Generator::GenerateLegalMoves, "Generates the set of legal moves for the current board", py::arg("board"))
-        .def("get_legal_moves", &Generator::GetLegalMoves)
+        .def("generate_legal_moves", py::overload_cast<const std::shared_ptr<Board>&>(&Generator::GenerateLegalMoves), "Generates the set of legal moves for the current board", py::arg("board"))
+        .def("get_legal_moves", [](const Generator &generator) {
+            const MoveList &moves = generator.GetLegalMoves();
+            return std::vector<U16>(moves.begin(), moves.end());
+        })
         .def("get_n_legal_moves", &Generator::GetNLegalMoves)
         .def("is_under_attack", &Generator::IsUnderAttack);
 }
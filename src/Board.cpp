@@ -1,104 +1,168 @@
 #include "Board.hpp"
 
-Board::Board() : fPawnPhase(0), fKnightPhase(1), fBishopPhase(1), fRookPhase(2), fQueenPhase(4) {
-    InitZobristKeys();
+Board::Board() {
     Reset();
-    fTotalPhase = fPawnPhase*16 + fKnightPhase*4 + fBishopPhase*4 + fRookPhase*4 + fQueenPhase*2;
 }
 
-void Board::InitZobristKeys() {
-    for (int i = 0; i < NUM_SQUARES; ++i) {
-        for(int j = 0; j < NUM_PIECE_TYPES; ++j) {
-            fKeys.pieceKeys[i][j] = GetRandomKey();
+U64 Board::ComputeHash() const {
+    U64 hash = 0;
+
+    // Piece placement, read from the bitboards so this stays independent of the mailbox
+    for(int iBoard = 0; iBoard < 12; ++iBoard) {
+        const Color color = iBoard < 6 ? Color::White : Color::Black;
+        const Piece piece = static_cast<Piece>(iBoard >= 6 ? iBoard - 5 : iBoard + 1);
+        U64 pieces = fBoards[iBoard];
+        while(pieces) {
+            hash ^= GetPieceKey(color, piece, 1ULL << __builtin_ctzll(pieces));
+            pieces &= pieces - 1;
         }
     }
-    fKeys.sideToMoveKey[0] = GetRandomKey(); // White to move
-    fKeys.sideToMoveKey[1] = GetRandomKey(); // Black to move
-    for(int i = 0; i < 4; ++i) {
-        fKeys.castlingKeys[i] = GetRandomKey();
-    }
-    fKeys.enPassantKey = GetRandomKey();
+    // Side to move
+    hash ^= ZOBRIST_KEYS.sideToMoveKey[(int)fColorToMove];
+
+    hash ^= ZOBRIST_KEYS.castlingKeys[fCastlingRights];
+    hash ^= GetEnPassantKey();
+
+    return hash;
 }
 
-U64 Board::GetHash() {
-    U64 hash = 0;
+U64 Board::GetEnPassantKey() const {
+    // Only hash the en-passant square when one of the fColorToMove pawns could actually capture onto it
+    if(!fEnPassant)
+        return 0;
+    const U64 attackers = fColorToMove == Color::White ? (south_east(fEnPassant) | south_west(fEnPassant)) : (north_east(fEnPassant) | north_west(fEnPassant));
+    if(attackers & fBoards[fColorToMove == Color::White ? 0 : 6])
+        return ZOBRIST_KEYS.enPassantKeys[get_file_number(fEnPassant) - 1];
+    return 0;
+}
 
-    // Piece placement
+void Board::VerifyIncrementalState() const {
+    const U64 expected = ComputeHash();
+    const U64 occupancy = std::accumulate(std::begin(fBoards), std::end(fBoards), U64(0), std::bit_or<U64>());
+    bool mailboxMatches = true;
     for(int i = 0; i < NSQUARES; ++i) {
-        U64 square = 1ULL << i;
-        std::pair<Color, Piece> occupation = GetIsOccupied(square);
-
-        if(occupation.second != Piece::Null) {
-            // Piece is in range [1,6], then add zero for white or 6 for black
-            hash ^= fKeys.pieceKeys[__builtin_ctzll(square)][(int)occupation.second + (occupation.first == Color::White ? 0 : 6)];
-        }
-    }
-    // Side to move
-    hash ^= fKeys.sideToMoveKey[(int)fColorToMove];
-
-    // Castling rights
-    bool wKingside = fWhiteKingsideRookMoved == 0;
-    bool bKingside = fBlackKingsideRookMoved == 0;
-    bool wQueenside = fWhiteQueensideRookMoved == 0;
-    bool bQueenside = fBlackQueensideRookMoved == 0;
-    if(fWhiteKingMoved == 0) {
-        if(wKingside)
-            hash ^= fKeys.castlingKeys[0];
-        if(wQueenside)
-            hash ^= fKeys.castlingKeys[1];
+        const std::pair<Color, Piece> occupant = fMailbox[i];
+        U64 board = 0;
+        if(occupant.second != Piece::Null)
+            board = fBoards[(int)occupant.second + (occupant.first == Color::White ? -1 : 5)];
+        mailboxMatches &= occupant.second == Piece::Null ? !(occupancy & (1ULL << i)) : (board & (1ULL << i)) != 0;
     }
-    if(fBlackKingMoved == 0) {
-        if(bKingside)
-            hash ^= fKeys.castlingKeys[2];
-        if(bQueenside)
-            hash ^= fKeys.castlingKeys[3];
-    }
-
-    // En passant square (i.e. en-passant now available)
-    if(fMadeMoves.size() > 0) {
-        const U16 lastMove = GetLastMove();
-        const U64 target = GetMoveTarget(lastMove);
-        const U8 startRank = get_rank_number(GetMoveOrigin(lastMove));
-        const U8 endRank = get_rank_number(target);
-        bool wasPawnMoved = GetIsOccupied(target).second == Piece::Pawn;
-        const bool wasDoubeMove = fColorToMove == Color::White ? (startRank == 7 && endRank == 5) : (startRank == 2 && endRank == 4);
-
-        if(wasPawnMoved && wasDoubeMove) {
-            // potential for en-passant if either of the fColorToMove pieces pawns directly adjacent
-            U64 pawns = GetBoard(fColorToMove, Piece::Pawn);
-            if((east(target) | west(target)) & pawns)
-                hash ^= fKeys.enPassantKey;
+    const U64 whiteOccupancy = std::accumulate(fBoards, fBoards + 6, U64(0), std::bit_or<U64>());
+    const bool occupancyMatches = fOccupancy == occupancy && fColorBoards[0] == whiteOccupancy && fColorBoards[1] == (occupancy ^ whiteOccupancy);
+    int materialScore = 0;
+    int phaseMaterial = 0;
+    for(int i = 0; i < NSQUARES; ++i) {
+        if(fMailbox[i].second != Piece::Null) {
+            materialScore += GetPieceScore(fMailbox[i].first, fMailbox[i].second, i);
+            phaseMaterial += PHASE_WEIGHTS[(int)fMailbox[i].second];
         }
     }
-
-    return hash;
+    const bool evaluationMatches = fMaterialScore == materialScore && fPhaseMaterial == phaseMaterial;
+    if(fHash != expected || !mailboxMatches || !occupancyMatches || !evaluationMatches) {
+        std::cerr << "Incremental hash " << fHash << " (recomputed " << expected << "), mailbox (match = " << mailboxMatches << "), occupancy (match = " << occupancyMatches << ") or material (match = " << evaluationMatches << ") is out of sync after " << fPly << " moves\n";
+        PrintFEN();
+        std::abort();
+    }
 }
 
-Board::Board(const Board& other) : fPawnPhase(0), fKnightPhase(1), fBishopPhase(1), fRookPhase(2), fQueenPhase(4) {
+Board::Board(const Board& other) {
     // Copy over the bitboards
     for(int iBoard = 0; iBoard < 12; ++iBoard) {
         this->fBoards[iBoard] = other.fBoards[iBoard];
     }
+    std::copy(std::begin(other.fMailbox), std::end(other.fMailbox), std::begin(this->fMailbox));
+    this->fColorBoards[0] = other.fColorBoards[0];
+    this->fColorBoards[1] = other.fColorBoards[1];
+    this->fOccupancy = other.fOccupancy;
 
-    this->fTotalPhase = other.fTotalPhase;
+    this->fMaterialScore = other.fMaterialScore;
+    this->fPhaseMaterial = other.fPhaseMaterial;
+    this->fHash = other.fHash;
 
     // Copy over the game state variables
-    this->fMadeMoves = other.fMadeMoves;
+    this->fStates = other.fStates;
+    this->fPly = other.fPly;
     this->fHalfMoves = other.fHalfMoves;
     this->fGameState = other.fGameState;
-    this->fWhiteKingMoved = other.fWhiteKingMoved;
-    this->fBlackKingMoved = other.fBlackKingMoved;
-    this->fWhiteKingsideRookMoved = other.fWhiteKingsideRookMoved;
-    this->fWhiteQueensideRookMoved = other.fWhiteQueensideRookMoved;
-    this->fBlackKingsideRookMoved = other.fBlackKingsideRookMoved;
-    this->fBlackQueensideRookMoved = other.fBlackQueensideRookMoved;
-    this->fEnPassantFENTarget = other.fEnPassantFENTarget;
+    this->fCastlingRights = other.fCastlingRights;
+    this->fEnPassant = other.fEnPassant;
     this->fColorToMove = other.fColorToMove;
 
     // Copy over how the board was initalised
     this->fWasLoadedFromFEN = other.fWasLoadedFromFEN;
 }
 
+bool Board::IsRepetition(const int nPrevious) const {
+    int count = 0;
+    const int earliest = std::max(0, fPly - fHalfMoves);
+    // Position two moves back can never match, but stepping from there keeps the null move check covering every move
+    for(int iPly = fPly - 2; iPly >= earliest; iPly -= 2) {
+        if(!fStates[iPly].move || !fStates[iPly + 1].move) // Positions either side of a null move are not real repeats
+            return false;
+        if(fStates[iPly].hash == fHash && ++count >= nPrevious)
+            return true;
+    }
+    return false;
+}
+
+PositionSnapshot Board::GetSnapshot() const {
+    PositionSnapshot snapshot;
+    std::copy(std::begin(fBoards), std::end(fBoards), std::begin(snapshot.boards));
+    snapshot.hash = fHash;
+    snapshot.enPassant = fEnPassant;
+    snapshot.materialScore = fMaterialScore;
+    snapshot.phaseMaterial = fPhaseMaterial;
+    snapshot.halfMoves = fHalfMoves;
+    snapshot.ply = fPly;
+    snapshot.castlingRights = fCastlingRights;
+    snapshot.colorToMove = fColorToMove;
+    return snapshot;
+}
+
+void Board::LoadSnapshot(const PositionSnapshot &snapshot) {
+    // A snapshot from earlier in this board's game finds the record of the move made from it, otherwise the records below
+    // its ply are another game's history and must not be read as repetitions
+    const bool ownHistory = snapshot.ply < fPly ? fStates[snapshot.ply].hash == snapshot.hash : snapshot.ply == fPly && snapshot.hash == fHash;
+    if(snapshot.ply >= (int)fStates.size())
+        fStates.resize(2 * snapshot.ply);
+    if(!ownHistory)
+        std::fill(fStates.begin(), fStates.begin() + snapshot.ply, StateInfo{}); // Null records stop the repetition search
+
+    // Only squares whose occupant changed need their mailbox entry rewritten, a handful after a single move
+    U64 changed = 0;
+    fColorBoards[0] = fColorBoards[1] = 0;
+    for(int iBoard = 0; iBoard < 12; ++iBoard) {
+        changed |= fBoards[iBoard] ^ snapshot.boards[iBoard];
+        fBoards[iBoard] = snapshot.boards[iBoard];
+        fColorBoards[iBoard < 6 ? 0 : 1] |= fBoards[iBoard];
+    }
+    fOccupancy = fColorBoards[0] | fColorBoards[1];
+    while(changed) {
+        const int lsb = __builtin_ctzll(changed);
+        fMailbox[lsb] = std::make_pair(Color::White, Piece::Null);
+        for(int iBoard = 0; iBoard < 12; ++iBoard) {
+            if(fBoards[iBoard] & (1ULL << lsb)) {
+                fMailbox[lsb] = std::make_pair(iBoard < 6 ? Color::White : Color::Black, static_cast<Piece>(iBoard >= 6 ? iBoard - 5 : iBoard + 1));
+                break;
+            }
+        }
+        changed &= changed - 1;
+    }
+
+    fHash = snapshot.hash;
+    fEnPassant = snapshot.enPassant;
+    fMaterialScore = snapshot.materialScore;
+    fPhaseMaterial = snapshot.phaseMaterial;
+    fHalfMoves = snapshot.halfMoves;
+    fPly = snapshot.ply;
+    fCastlingRights = snapshot.castlingRights;
+    fColorToMove = snapshot.colorToMove;
+    fGameState = State::Play;
+#ifdef DEBUG_HASH
+    VerifyIncrementalState();
+#endif
+}
+
 void Board::Reset() {
     fBoards[0] = RANK_2; // White pawns
     fBoards[1] = RANK_1 & (FILE_C | FILE_F); // White bishops
@@ -115,63 +179,32 @@ void Board::Reset() {
 
     fHalfMoves = 0;
     fGameState = State::Play;
-    fWhiteKingMoved = 0;
-    fBlackKingMoved = 0;
-    fWhiteKingsideRookMoved = 0;
-    fWhiteQueensideRookMoved = 0;
-    fBlackKingsideRookMoved = 0;
-    fBlackQueensideRookMoved = 0;
+    fCastlingRights = CASTLING_ALL;
     fWasLoadedFromFEN = false;
-    fEnPassantFENTarget = 0;
+    fEnPassant = 0;
     fColorToMove = Color::White;
 
-    fMovedPieces = {};
-    fTakenPieces = {};
-    fMadeMoves = {};
-    fHistory = {};
-}
-
-Piece Board::GetMovePiece(const U16 move) const {
-    const U64 origin = GetMoveOrigin(move);
-    return GetIsOccupied(origin).second;
-}
-
-Piece Board::GetMoveTakenPiece(const U16 move) const {
-    const U64 target = GetMoveTarget(move);
-    return GetIsOccupied(target).second;
-}
-
-bool Board::GetMoveIsEnPassant(const U16 move, const Piece movedPiece, const bool targetIsNull) const {
-    // To be en-passant we must be moving a pawn -- assumes move has not yet happened!
-    if(movedPiece != Piece::Pawn)
-        return false;
-    
-    const U64 origin = GetMoveOrigin(move);
-    const U64 target = GetMoveTarget(move);
-
-    // Move is diagonally forwards, regardless of colour
-    if(!((north_east(origin) | north_west(origin) | south_west(origin) | south_east(origin)) & target))
-        return false;
-
-    if(targetIsNull)
-        return true;
-
-    return false;
+    if(fStates.size() < MAX_GAME_PLY)
+        fStates.resize(MAX_GAME_PLY);
+    fPly = 0;
+    FillMailbox();
+    fHash = ComputeHash();
 }
 
 void Board::UndoMove() {
     // Essentially just does the inverse of MakeMove
-    if(fMadeMoves.size() < 1) {
+    if(fPly < 1) {
         Reset(); // Cannot undo more moves than exist in the move tree
         return;
     }
 
     // Last move in the stack will be from player of opposing colour
     const Color movingColor = fColorToMove == Color::White ? Color::Black : Color::White;
-    U16 move = fMadeMoves.back();
-
-    const Piece movedPiece = fMovedPieces.back();
-    const Piece takenPiece = fTakenPieces.back();
+    const StateInfo &state = fStates[--fPly];
+    const U16 move = state.move;
+    const U16 flag = GetMoveFlag(move);
+    const Piece movedPiece = state.movedPiece;
+    const Piece takenPiece = state.takenPiece;
     const U64 start = GetMoveOrigin(move);
     const U64 target = GetMoveTarget(move);
     const U8 targetLSB = __builtin_ctzll(target);
@@ -180,90 +213,70 @@ void Board::UndoMove() {
     // Set piece back at the starting position
     set_bit(*origin, __builtin_ctzll(start));
 
-    // Clear the piece at the target position
-    clear_bit(*origin, targetLSB);
-
-    // Handle en-passant properly
-    if(GetMoveIsEnPassant(move, movedPiece, takenPiece == Piece::Null)) {
-        // special case old bit-board already re-instated need to put piece back in correct place now
-        // crossing of the origin RANK and target FILE = taken piece position 
-        set_bit(*GetBoardPointer(fColorToMove, Piece::Pawn), __builtin_ctzll(get_rank(start) & get_file(target)));
+    // Clear the piece at the target position, a promoted pawn is on the board of the piece it became
+    if(GetMoveIsPromotion(move)) {
+        clear_bit(*GetBoardPointer(movingColor, GetMovePromotionPiece(move)), targetLSB);
+    } else {
+        clear_bit(*origin, targetLSB);
     }
 
-    // Handle pieces being taken
-    if(takenPiece != Piece::Null) {
+    fMailbox[__builtin_ctzll(start)] = std::make_pair(movingColor, movedPiece);
+    fMailbox[targetLSB] = takenPiece == Piece::Null ? std::make_pair(Color::White, Piece::Null) : std::make_pair(fColorToMove, takenPiece);
+    fColorBoards[(int)movingColor] ^= start | target;
+
+    if(flag == MOVE_EN_PASSANT) {
+        // crossing of the origin RANK and target FILE = taken piece position 
+        const U8 takenPawnLSB = __builtin_ctzll(get_rank(start) & get_file(target));
+        set_bit(*GetBoardPointer(fColorToMove, Piece::Pawn), takenPawnLSB);
+        fMailbox[takenPawnLSB] = std::make_pair(fColorToMove, Piece::Pawn);
+        set_bit(fColorBoards[(int)fColorToMove], takenPawnLSB);
+    } else if(takenPiece != Piece::Null) {
         U64 *targ = GetBoardPointer(fColorToMove, takenPiece);
         set_bit(*targ, targetLSB); // Put the piece back
-        if(takenPiece == Piece::Rook) { // Rook being taken counts as a move for the rook if not moved before
-            if(target & SQUARE_H1) {
-                fWhiteKingsideRookMoved--;
-            } else if(target & SQUARE_A1) {
-                fWhiteQueensideRookMoved--;
-            } else if(target & SQUARE_H8) {
-                fBlackKingsideRookMoved--;
-            } else if(target & SQUARE_A8) {
-                fBlackQueensideRookMoved--;
-            }
-        }
-    } else if(GetMoveIsCastling(move)) { // Need to move the rook as well
-        U64 *rook = GetBoardPointer(movingColor, Piece::Rook);
-        U64 targRank = movingColor == Color::White ? RANK_1 : RANK_8;
-        // See where the origin was (that tells us which rook needs moving and to where)
-        if(target & FILE_G) { // Kingside white castling (rook h1 -> f1)
-            set_bit(*rook, __builtin_ctzll(targRank & FILE_H));
-            clear_bit(*rook, __builtin_ctzll(targRank & FILE_F));
-            movingColor == Color::White ? fWhiteKingsideRookMoved-- : fBlackKingsideRookMoved--;          
-        // Don't need to check rank, implicitly done by GetMoveIsCastling(move)
-        } else if(target & FILE_C) {  // Queenside white castling (rook a1 -> d1)
-            set_bit(*rook, __builtin_ctzll(targRank & FILE_A));
-            clear_bit(*rook, __builtin_ctzll(targRank & FILE_D));
-            movingColor == Color::White ? fWhiteQueensideRookMoved-- : fBlackQueensideRookMoved--;
-        }
+        set_bit(fColorBoards[(int)fColorToMove], targetLSB);
+    } else if(GetMoveIsCastling(move)) { // Need to move the rook back as well
+        const bool white = movingColor == Color::White;
+        const U64 rookFrom = flag == MOVE_KING_CASTLE ? (white ? SQUARE_H1 : SQUARE_H8) : (white ? SQUARE_A1 : SQUARE_A8);
+        const U64 rookTo = flag == MOVE_KING_CASTLE ? (white ? SQUARE_F1 : SQUARE_F8) : (white ? SQUARE_D1 : SQUARE_D8);
+        *GetBoardPointer(movingColor, Piece::Rook) ^= rookFrom | rookTo;
+        fMailbox[__builtin_ctzll(rookFrom)] = std::make_pair(movingColor, Piece::Rook);
+        fMailbox[__builtin_ctzll(rookTo)] = std::make_pair(Color::White, Piece::Null);
+        fColorBoards[(int)movingColor] ^= rookFrom | rookTo;
     }
 
-    if(movedPiece == Piece::King)
-        movingColor == Color::White ? fWhiteKingMoved-- : fBlackKingMoved--;
-
-    if(movedPiece == Piece::Rook) {
-        if(movingColor == Color::White) {
-            if(start & SQUARE_A1) {
-                fWhiteQueensideRookMoved--;
-            } else if(start & SQUARE_H1) {
-                fWhiteKingsideRookMoved--;
-            }
-        } else {
-            if(start & SQUARE_A8) {
-                fBlackQueensideRookMoved--;
-            } else if(start & SQUARE_H8) {
-                fBlackKingsideRookMoved--;
-            }
-        }
-    }
-
-    if(GetMoveIsPromotion(move)) {
-        // Clear bit from promotional bitboard
-        U64 *promotionBoard = GetBoardPointer(movingColor, GetMovePromotionPiece(move));
-        clear_bit(*promotionBoard, targetLSB);
-    }
-
-    fHalfMoves--; // Only reduces if move was not a capture of pawn push
-    if(movedPiece == Piece::Pawn || takenPiece != Piece::Null)
-        fHalfMoves = 0;
-
-    fMovedPieces.pop_back();
-    fTakenPieces.pop_back();
+    // Everything that can't be recovered from the move is copied straight back
+    fHash = state.hash;
+    fEnPassant = state.enPassant;
+    fHalfMoves = state.halfMoves;
+    fCastlingRights = state.castlingRights;
+    fMaterialScore = state.materialScore;
+    fPhaseMaterial = state.phaseMaterial;
+    fOccupancy = fColorBoards[0] | fColorBoards[1];
     fGameState = State::Play;
     fColorToMove = movingColor;
-    fMadeMoves.pop_back();
+#ifdef DEBUG_HASH
+    VerifyIncrementalState();
+#endif
 }
 
 void Board::MakeMove(const U16 move) {
+    // The flag set during generation says what kind of move this is, only captures need to look at the target square
+    const U16 flag = GetMoveFlag(move);
     const Piece movedPiece = GetMovePiece(move);
-    const Piece takenPiece = GetMoveTakenPiece(move);
+    const Piece takenPiece = GetMoveIsCapture(move) && flag != MOVE_EN_PASSANT ? GetMoveTakenPiece(move) : Piece::Null;
     const U64 start = GetMoveOrigin(move);
     const U64 target = GetMoveTarget(move);
     const U8 targetLSB = __builtin_ctzll(target);
+    const Color otherColor = fColorToMove == Color::White ? Color::Black : Color::White;
     U64 *origin = GetBoardPointer(fColorToMove, movedPiece);
+
+    if(fPly >= (int)fStates.size())
+        fStates.resize(2 * fStates.size()); // Only reached in games far longer than MAX_GAME_PLY
+    fStates[fPly++] = StateInfo{fHash, fEnPassant, fHalfMoves, move, movedPiece, takenPiece, fCastlingRights, fMaterialScore, fPhaseMaterial};
+
+    // Castling and en-passant keys are removed here and those of the new position added back at the end
+    fHash ^= ZOBRIST_KEYS.castlingKeys[fCastlingRights] ^ GetEnPassantKey();
+    fHash ^= GetPieceKey(fColorToMove, movedPiece, start) ^ GetPieceKey(fColorToMove, movedPiece, target);
     
     // Remove piece from the starting position
     clear_bit(*origin, __builtin_ctzll(start));
@@ -271,106 +284,97 @@ void Board::MakeMove(const U16 move) {
     // Set the piece at the new position
     set_bit(*origin, targetLSB);
 
-    // Handle en-passant happening (the takenPiece counts as null)
-    if(GetMoveIsEnPassant(move, movedPiece, takenPiece == Piece::Null)) {
-        clear_bit(*GetBoardPointer(fColorToMove == Color::White ? Color::Black : Color::White, Piece::Pawn), __builtin_ctzll(get_rank(start) & get_file(target)));
-    }
-
-    // Handle pieces being taken
-    if(takenPiece != Piece::Null) {
-        U64 *targ = GetBoardPointer(fColorToMove == Color::White ? Color::Black : Color::White, takenPiece);
-        // Check, move could be en-passant
+    fMailbox[__builtin_ctzll(start)] = std::make_pair(Color::White, Piece::Null);
+    fMailbox[targetLSB] = std::make_pair(fColorToMove, movedPiece);
+    fColorBoards[(int)fColorToMove] ^= start | target;
+    fMaterialScore += GetPieceScore(fColorToMove, movedPiece, targetLSB) - GetPieceScore(fColorToMove, movedPiece, move & ORIGIN_MASK);
+
+    if(flag == MOVE_EN_PASSANT) { // The taken pawn is beside the target, not on it
+        const U64 takenPawn = get_rank(start) & get_file(target);
+        clear_bit(*GetBoardPointer(otherColor, Piece::Pawn), __builtin_ctzll(takenPawn));
+        fMailbox[__builtin_ctzll(takenPawn)] = std::make_pair(Color::White, Piece::Null);
+        fColorBoards[(int)otherColor] ^= takenPawn;
+        fMaterialScore -= GetPieceScore(otherColor, Piece::Pawn, __builtin_ctzll(takenPawn));
+        fHash ^= GetPieceKey(otherColor, Piece::Pawn, takenPawn);
+    } else if(takenPiece != Piece::Null) {
+        U64 *targ = GetBoardPointer(otherColor, takenPiece);
         clear_bit(*targ, targetLSB);
-        if(takenPiece == Piece::Rook) { // Taking the rook counts as it "moving" so no castling available
-            if(target & SQUARE_H1) {
-                fWhiteKingsideRookMoved++;
-            } else if(target & SQUARE_A1) {
-                fWhiteQueensideRookMoved++;
-            } else if(target & SQUARE_H8) {
-                fBlackKingsideRookMoved++;
-            } else if(target & SQUARE_A8) {
-                fBlackQueensideRookMoved++;
-            }
-        }
+        fColorBoards[(int)otherColor] ^= target;
+        fMaterialScore -= GetPieceScore(otherColor, takenPiece, targetLSB);
+        fPhaseMaterial -= PHASE_WEIGHTS[(int)takenPiece];
+        fHash ^= GetPieceKey(otherColor, takenPiece, target);
     } else if(GetMoveIsCastling(move)) { // Need to move the rook as well
-        U64 *rook = GetBoardPointer(fColorToMove, Piece::Rook);
-        // See where the origin was (that tells us which rook needs moving and to where)
-        if(target & SQUARE_G1) { // Kingside white castling (rook h1 -> f1)
-            clear_bit(*rook, __builtin_ctzll(SQUARE_H1));
-            set_bit(*rook, __builtin_ctzll(SQUARE_F1));
-            fWhiteKingsideRookMoved++;
-        } else if(target & SQUARE_C1) {  // Queenside white castling (rook a1 -> d1)
-            clear_bit(*rook, __builtin_ctzll(SQUARE_A1));
-            set_bit(*rook, __builtin_ctzll(SQUARE_D1));
-            fWhiteQueensideRookMoved++;
-        } else if(target & SQUARE_G8) { // Kingside black castling
-            clear_bit(*rook, __builtin_ctzll(SQUARE_H8));
-            set_bit(*rook, __builtin_ctzll(SQUARE_F8));
-            fBlackKingsideRookMoved++;
-        } else if(target & SQUARE_C8) { // Queenside black castling
-            clear_bit(*rook, __builtin_ctzll(SQUARE_A8));
-            set_bit(*rook, __builtin_ctzll(SQUARE_D8));
-            fBlackQueensideRookMoved++;
-        }
+        const bool white = fColorToMove == Color::White;
+        const U64 rookFrom = flag == MOVE_KING_CASTLE ? (white ? SQUARE_H1 : SQUARE_H8) : (white ? SQUARE_A1 : SQUARE_A8);
+        const U64 rookTo = flag == MOVE_KING_CASTLE ? (white ? SQUARE_F1 : SQUARE_F8) : (white ? SQUARE_D1 : SQUARE_D8);
+        *GetBoardPointer(fColorToMove, Piece::Rook) ^= rookFrom | rookTo;
+        fHash ^= GetPieceKey(fColorToMove, Piece::Rook, rookFrom) ^ GetPieceKey(fColorToMove, Piece::Rook, rookTo);
+        fMailbox[__builtin_ctzll(rookFrom)] = std::make_pair(Color::White, Piece::Null);
+        fMailbox[__builtin_ctzll(rookTo)] = std::make_pair(fColorToMove, Piece::Rook);
+        fColorBoards[(int)fColorToMove] ^= rookFrom | rookTo;
+        fMaterialScore += GetPieceScore(fColorToMove, Piece::Rook, __builtin_ctzll(rookTo)) - GetPieceScore(fColorToMove, Piece::Rook, __builtin_ctzll(rookFrom));
     }
 
-    if(movedPiece == Piece::King)
-        fColorToMove == Color::White ? fWhiteKingMoved++ : fBlackKingMoved++;
-
-    if(movedPiece == Piece::Rook) {
-        if(fColorToMove == Color::White) {
-            if(start & SQUARE_A1) {
-                fWhiteQueensideRookMoved++;
-            } else if(start & SQUARE_H1) {
-                fWhiteKingsideRookMoved++;
-            }
-        } else {
-            if(start & SQUARE_A8) {
-                fBlackQueensideRookMoved++;
-            } else if(start & SQUARE_H8) {
-                fBlackKingsideRookMoved++;
-            }
-        }
-    }
+    // Moving the king or a rook off its home square, or capturing a rook on it, loses the matching rights
+    fCastlingRights &= CASTLING_RIGHTS_MASK[move & ORIGIN_MASK] & CASTLING_RIGHTS_MASK[targetLSB];
 
     if(GetMoveIsPromotion(move)) {
         clear_bit(*origin, targetLSB); // Undo the setting that already happened
-        U64 *targBoard = GetBoardPointer(fColorToMove, GetMovePromotionPiece(move) == Piece::Null ? Piece::Queen : GetMovePromotionPiece(move));
+        const Piece promotionPiece = GetMovePromotionPiece(move);
+        U64 *targBoard = GetBoardPointer(fColorToMove, promotionPiece);
         set_bit(*targBoard, targetLSB);
+        fMailbox[targetLSB].second = promotionPiece;
+        fHash ^= GetPieceKey(fColorToMove, movedPiece, target) ^ GetPieceKey(fColorToMove, promotionPiece, target);
+        fMaterialScore += GetPieceScore(fColorToMove, promotionPiece, targetLSB) - GetPieceScore(fColorToMove, movedPiece, targetLSB);
+        fPhaseMaterial += PHASE_WEIGHTS[(int)promotionPiece];
     }
 
+    // A double pawn push makes the skipped square available for en-passant on the next move only
+    fEnPassant = 0;
+    if(flag == MOVE_DOUBLE_PUSH)
+        fEnPassant = fColorToMove == Color::White ? north(start) : south(start);
+
     fHalfMoves++;
-    if(movedPiece == Piece::Pawn || takenPiece != Piece::Null)
+    if(movedPiece == Piece::Pawn || GetMoveIsCapture(move))
         fHalfMoves = 0;
 
-    fColorToMove = fColorToMove == Color::White ? Color::Black : Color::White;
-    fMadeMoves.push_back(move);
-    fMovedPieces.push_back(movedPiece);
-    fTakenPieces.push_back(takenPiece);
-}
+    fOccupancy = fColorBoards[0] | fColorBoards[1];
+    fColorToMove = otherColor;
 
-U64 Board::GetBoard(const Color color, const U64 occupiedPosition) {
-    U8 offset = color == Color::White ? -1 : 5;
-    for(Piece p : PIECES) {
-        if(fBoards[(int)p + offset] & occupiedPosition)
-            return fBoards[(int)p + offset];
-    }
-    return U64{0};
+    fHash ^= ZOBRIST_KEYS.sideToMoveKey[0] ^ ZOBRIST_KEYS.sideToMoveKey[1];
+    fHash ^= ZOBRIST_KEYS.castlingKeys[fCastlingRights] ^ GetEnPassantKey();
+#ifdef DEBUG_HASH
+    VerifyIncrementalState();
+#endif
 }
 
-U64 Board::GetBoard(const Color color) {
-    const U8 startOffset = color == Color::White ? 0 : 6;
-    const U8 endOffset = startOffset + 6;
-    return std::accumulate(fBoards + startOffset, fBoards + endOffset, 0ULL, std::bit_or<U64>());
+void Board::MakeNullMove() {
+    if(fPly >= (int)fStates.size())
+        fStates.resize(2 * fStates.size());
+    fStates[fPly++] = StateInfo{fHash, fEnPassant, fHalfMoves, 0, Piece::Null, Piece::Null, fCastlingRights, fMaterialScore, fPhaseMaterial};
+
+    fHash ^= GetEnPassantKey();
+    fEnPassant = 0;
+    fHalfMoves++;
+    fColorToMove = fColorToMove == Color::White ? Color::Black : Color::White;
+    fHash ^= ZOBRIST_KEYS.sideToMoveKey[0] ^ ZOBRIST_KEYS.sideToMoveKey[1];
+#ifdef DEBUG_HASH
+    VerifyIncrementalState();
+#endif
 }
 
-U64 Board::GetBoard(const Color color, const Piece piece) {
-    return color == Color::White ? fBoards[(int)piece - 1] : fBoards[(int)piece + 5];
+void Board::UndoNullMove() {
+    const StateInfo &state = fStates[--fPly];
+    fHash = state.hash;
+    fEnPassant = state.enPassant;
+    fHalfMoves = state.halfMoves;
+    fColorToMove = fColorToMove == Color::White ? Color::Black : Color::White;
+    fGameState = State::Play;
 }
 
-U64 Board::GetBoard(const Piece piece) {
-    // Assumes you want the color to move's board for the presiding piece
-    return fColorToMove == Color::White ? fBoards[(int)piece - 1] : fBoards[(int)piece + 5];
+U64 Board::GetBoard(const Color color, const U64 occupiedPosition) {
+    const std::pair<Color, Piece> occupant = GetIsOccupied(occupiedPosition, color);
+    return occupant.second == Piece::Null ? U64{0} : GetBoard(color, occupant.second);
 }
 
 U64* Board::GetBoardPointer(const Color color, const Piece piece) {
@@ -380,6 +384,19 @@ U64* Board::GetBoardPointer(const Color color, const Piece piece) {
 }
 
 void Board::SetBoard(const Color color, const Piece piece, const U64 board) {
+    const U64 previous = GetBoard(color, piece);
+    U64 changed = previous ^ board; // Squares gaining or losing this piece
+    while(changed) {
+        const U8 lsb = __builtin_ctzll(changed);
+        fHash ^= GetPieceKey(color, piece, 1ULL << lsb);
+        const int sign = (board & (1ULL << lsb)) ? 1 : -1;
+        fMaterialScore += sign * GetPieceScore(color, piece, lsb);
+        fPhaseMaterial += sign * PHASE_WEIGHTS[(int)piece];
+        fMailbox[lsb] = (board & (1ULL << lsb)) ? std::make_pair(color, piece) : std::make_pair(Color::White, Piece::Null);
+        changed &= changed - 1;
+    }
+    fColorBoards[(int)color] ^= previous ^ board;
+    fOccupancy = fColorBoards[0] | fColorBoards[1];
     if(color == Color::White) {
         fBoards[(int)piece - 1] = board;
     } else {
@@ -392,6 +409,30 @@ void Board::EmptyBoards() {
     for(int i = 0; i < 12; i++) {
         fBoards[i] = empty;
     }
+    std::fill(std::begin(fMailbox), std::end(fMailbox), std::make_pair(Color::White, Piece::Null));
+    fColorBoards[0] = fColorBoards[1] = fOccupancy = 0;
+    fMaterialScore = fPhaseMaterial = 0;
+}
+
+void Board::FillMailbox() {
+    std::fill(std::begin(fMailbox), std::end(fMailbox), std::make_pair(Color::White, Piece::Null));
+    fColorBoards[0] = fColorBoards[1] = 0;
+    fMaterialScore = fPhaseMaterial = 0;
+    for(int iBoard = 0; iBoard < 12; ++iBoard) {
+        U64 pieces = fBoards[iBoard];
+        fColorBoards[iBoard < 6 ? 0 : 1] |= pieces;
+        // We already know the mapping e.g. 0 = pawn, bishop, knight, rook, queen, king (white, black)
+        const Color color = iBoard < 6 ? Color::White : Color::Black;
+        const Piece piece = static_cast<Piece>(iBoard >= 6 ? iBoard - 5 : iBoard + 1);
+        while(pieces) {
+            const int lsb = __builtin_ctzll(pieces);
+            fMailbox[lsb] = std::make_pair(color, piece);
+            fMaterialScore += GetPieceScore(color, piece, lsb);
+            fPhaseMaterial += PHASE_WEIGHTS[(int)piece];
+            pieces &= pieces - 1;
+        }
+    }
+    fOccupancy = fColorBoards[0] | fColorBoards[1];
 }
 
 void Board::LoadFEN(const std::string &fen) {
@@ -402,14 +443,8 @@ void Board::LoadFEN(const std::string &fen) {
     int file = 1;
     int ngaps = 0;
 
-    // Assume castling not possible
-    bool whiteKingCanCastle = false;
-    bool blackKingCanCastle = false;
-
-    bool whiteKingsideRookMoved = true;
-    bool whiteQueensideRookMoved = true;
-    bool blackKingsideRookMoved = true;
-    bool blackQueensideRookMoved = true;
+    // Assume castling not possible until the castling field says otherwise
+    fCastlingRights = 0;
 
     int iChar = 0;
     for (char c : fen) {
@@ -424,11 +459,12 @@ void Board::LoadFEN(const std::string &fen) {
             if (ngaps == 1) {
                 fColorToMove = (toupper(c) == 'B') ? Color::Black : Color::White;
             } else if (ngaps == 2) { // Castling terms
-                whiteKingCanCastle |= (c == 'K' || c == 'Q');
-                blackKingCanCastle |= (c == 'k' || c == 'q');
-            } else if(ngaps == 3 && !fEnPassantFENTarget) { // En-passant possibilities
+                const char *right = std::find(std::begin(CASTLING_FEN_CHARS), std::end(CASTLING_FEN_CHARS), c);
+                if(right != std::end(CASTLING_FEN_CHARS))
+                    fCastlingRights |= 1 << (right - std::begin(CASTLING_FEN_CHARS));
+            } else if(ngaps == 3 && !fEnPassant) { // En-passant possibilities
                 int rankNo = fen.at(iChar + 1) - '0';
-                fEnPassantFENTarget = get_file_from_char(c) & get_rank_from_number(rankNo);
+                fEnPassant = get_file_from_char(c) & get_rank_from_number(rankNo);
             } else if(ngaps == 4) {
                 char nextChar = fen.at(iChar + 1);
                 if(nextChar == ' ') {
@@ -446,19 +482,6 @@ void Board::LoadFEN(const std::string &fen) {
                 Color pieceColor = (isupper(c)) ? Color::White : Color::Black;
                 Piece pieceType = GetPieceFromChar(c);
                 U64 board = GetBoard(pieceColor, pieceType) | pos;
-                if(pieceColor == Color::White && pieceType == Piece::Rook) {
-                    if(pos & RANK_1 & FILE_A) {
-                        whiteQueensideRookMoved = false;
-                    } else if(pos & RANK_1 & FILE_H) {
-                        whiteKingsideRookMoved = false;
-                    }
-                } else if(pieceColor == Color::Black && pieceType == Piece::Rook) {
-                    if(pos & RANK_8 & FILE_A) {
-                        blackQueensideRookMoved = false;
-                    } else if(pos & RANK_8 & FILE_H) {
-                        blackKingsideRookMoved = false;
-                    }
-                }
                 SetBoard(pieceColor, pieceType, board);
                 file++;
             }
@@ -469,35 +492,7 @@ void Board::LoadFEN(const std::string &fen) {
     }
 
     fWasLoadedFromFEN = true;
-    fWhiteKingMoved = !whiteKingCanCastle;
-    fBlackKingMoved = !blackKingCanCastle;
-    fWhiteKingsideRookMoved = whiteKingsideRookMoved;
-    fWhiteQueensideRookMoved = whiteQueensideRookMoved;
-    fBlackKingsideRookMoved = blackKingsideRookMoved;
-    fBlackQueensideRookMoved = blackQueensideRookMoved;
-}
-
-std::pair<Color, Piece> Board::GetIsOccupied(const U64 pos) const {
-    for (int iBoard = 0; iBoard < 12; iBoard++) {
-        if(pos & fBoards[iBoard]) {
-            // We already know the mapping e.g. 0 = pawn, bishop, knight, rook, queen, king (white, black)
-            Piece pieceType = static_cast<Piece>(iBoard >= 6 ? iBoard - 5 : iBoard + 1);
-            return std::make_pair(iBoard < 6 ? Color::White : Color::Black, pieceType);
-        }
-    }
-    return std::make_pair(Color::White, Piece::Null);
-}
-
-std::pair<Color, Piece> Board::GetIsOccupied(const U64 pos, const Color color) const {
-    // Similar to GetIsOccupied(pos) but only searches the boards of the provided color
-    U8 offset = color == Color::White ? 0 : 6;
-    for (int iBoard = offset; iBoard < offset + 6; iBoard++) {
-        if(pos & fBoards[iBoard]) {
-            Piece pieceType = static_cast<Piece>(iBoard >= 6 ? iBoard - 5 : iBoard + 1);
-            return std::make_pair(color, pieceType);
-        }
-    }
-    return std::make_pair(color, Piece::Null);
+    fHash = ComputeHash();
 }
 
 void Board::PrintDetailedMove(U16 move) {
@@ -530,18 +525,6 @@ void Board::PrintDetailedMove(U16 move) {
     std::cout << moveStr << "\n";
 }
 
-float Board::GetGamePhase() {
-    // Setup such that the initial game state has a phase of 0 and the endgame (K v K+P) = 1
-    // Gets the number of each piece of material and subtracts from phase
-    float phase = fTotalPhase;
-    phase -= __builtin_popcountll(fBoards[0] | fBoards[6]) * fPawnPhase; // pawns
-    phase -= __builtin_popcountll(fBoards[1] | fBoards[7]) * fBishopPhase; // bishops
-    phase -= __builtin_popcountll(fBoards[2] | fBoards[8]) * fKnightPhase; // knights
-    phase -= __builtin_popcountll(fBoards[3] | fBoards[9]) * fRookPhase; // rook
-    phase -= __builtin_popcountll(fBoards[4] | fBoards[10]) * fQueenPhase; // queen
-    return std::min(std::max(phase / fTotalPhase, (float)0.0), (float)1.0);
-}
-
 void Board::PrintFEN() const {
     std::ostringstream fen;
     // Piece placement
@@ -587,52 +570,26 @@ void Board::PrintFEN() const {
     fen << ' ' << (fColorToMove == Color::White ? 'w' : 'b');
 
     // Other FEN fields (castling rights, en passant target square, halfmove clock, fullmove number)
-    std::vector<char> castlingChars{};
-    if(fWhiteKingMoved == 0) {
-        if(fWhiteKingsideRookMoved == 0) {
-            castlingChars.push_back('K');
-        }
-        if(fWhiteQueensideRookMoved == 0) {
-            castlingChars.push_back('Q');
-        } 
-    }
-    if(fBlackKingMoved == 0) {
-        if(fBlackKingsideRookMoved == 0) {
-            castlingChars.push_back('k');
-        }
-        if(fBlackQueensideRookMoved == 0) {
-            castlingChars.push_back('q');
-        } 
-    }
-
-    if(castlingChars.size() > 0) {
-        fen << ' ';
-        for(char c : castlingChars) {
-            fen << c;
-        }
+    fen << ' ';
+    for(int i = 0; i < 4; ++i) {
+        if(fCastlingRights & (1 << i))
+            fen << CASTLING_FEN_CHARS[i];
     }
+    if(!fCastlingRights)
+        fen << '-';
 
     // Available en-passant
-    bool wasEnPassant = false;
-    if(fMadeMoves.size() > 0) {
-        U16 move = fMadeMoves.back();
-        const U64 origin = GetMoveOrigin(move);
-        const U64 target = GetMoveTarget(move);
-        wasEnPassant = GetMoveIsEnPassant(move, fMovedPieces.back(), fTakenPieces.back() == Piece::Null);
-        if(wasEnPassant) {
-            int offset = fColorToMove == Color::White ? 1 : -1;
-            fen << get_file_char(origin) << get_rank_number(target) + offset;
-        }
-    }
-
-    if(!wasEnPassant)
+    if(fEnPassant) {
+        fen << ' ' << GetStringPosition(fEnPassant);
+    } else {
         fen << ' ' << '-';
+    }
 
     // Add the half-move clock
     fen << ' ' << fHalfMoves << ' ';
 
     // Add the full move count
-    int nFullMoves = (int)(fMadeMoves.size() / 2); // Always rounds down
+    int nFullMoves = fPly / 2; // Always rounds down
     fen << nFullMoves;
 
     std::cout << fen.str() << "\n";
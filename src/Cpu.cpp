@@ -0,0 +1,15 @@
+#include "Cpu.hpp"
+
+#include <cstdlib>
+
+void DetectCpuFeatures() {
+    CpuFeatures features;
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    features.popcnt = __builtin_cpu_supports("popcnt");
+    features.bmi2 = __builtin_cpu_supports("bmi2") && !__builtin_cpu_is("znver1") && !__builtin_cpu_is("znver2");
+#endif
+    if(std::getenv("CHESSENGINE_PORTABLE"))
+        features = CpuFeatures();
+    CPU_FEATURES = features;
+}
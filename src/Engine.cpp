@@ -4,7 +4,7 @@
 
 #include "Engine.hpp"
 
-Engine::Engine(const std::shared_ptr<Generator> &generator, const std::shared_ptr<Board> &board, const int maxDepth) : fGenerator(generator), fBoard(board), fMaxCacheSize(400000), fMaxDepth(maxDepth) {
+Engine::Engine(const std::shared_ptr<Generator> &generator, const std::shared_ptr<Board> &board, const int maxDepth) : fGenerator(generator), fBoard(board), fMaxCacheSize(400000), fMaxDepth(maxDepth), fCopyMake(false), fRootPly(0), fKillerMoves{} {
     fEvaluationCache.clear();
     const size_t initialBucketCount = fMaxCacheSize / 0.75; // Load factor of 0.75 is typically used for unordered_maps
     fEvaluationCache.reserve(initialBucketCount);
@@ -27,26 +27,10 @@ float Engine::Evaluate() {
         return it->second.first;
     }
 
-    fOtherColor = fBoard->GetColorToMove() == Color::White ? Color::Black : Color::White;
-    const int perspective = fBoard->GetColorToMove() == Color::White ? 1. : -1.;
+    fOtherColor = opposite(fBoard->GetColorToMove());
 
-    // Evaluate the position
-    float evaluation = 0.0;
-    // These functions are all defined such that positive values are GOOD for the colour to move
-    // so if it's black to move we need to add on minus these values to the evaluation
-    //evaluation += ForceKingToCornerEndgame();  // TODO: These functions must eval for both sides!!!
-    if(fDifficulty > 1000)
-        evaluation += EvaluatePassedPawns();
-    if(fDifficulty > 800)
-    evaluation += EvaluateKingSafety(); // Can be +ve or -ve
-    // These functions are return negative values i.e. BAD for the colour to move, agian needs to be adjusted
-    // by perspective
-    if(fDifficulty > 700)
-        evaluation += EvaluateBadBishops();
-    if(fDifficulty > 900)
-    evaluation += EvaluateIsolatedPawns();
-    
-    evaluation *= perspective;
+    // Evaluate the position, branching on the colour to move once so every term is specialised for that side
+    float evaluation = fBoard->GetColorToMove() == Color::White ? EvaluatePosition<Color::White>() : EvaluatePosition<Color::Black>();
     // Must be applied after the perspective flip
     evaluation += GetMaterialEvaluation(); // returns +ve if white advantage and -ve for black advantage
 
@@ -61,53 +45,71 @@ float Engine::Evaluate() {
     return evaluation; // Return in centipawns rather than pawns
 }
 
+template<Color Us>
+float Engine::EvaluatePosition() {
+    float evaluation = 0.0;
+    // These functions are all defined such that positive values are GOOD for the colour to move
+    // so if it's black to move we need to add on minus these values to the evaluation
+    //evaluation += ForceKingToCornerEndgame();  // TODO: These functions must eval for both sides!!!
+    if(fDifficulty > 1000)
+        evaluation += EvaluatePassedPawns<Us>();
+    if(fDifficulty > 800)
+        evaluation += EvaluateKingSafety<Us>(); // Can be +ve or -ve
+    // These functions are return negative values i.e. BAD for the colour to move, agian needs to be adjusted
+    // by perspective
+    if(fDifficulty > 700)
+        evaluation += EvaluateBadBishops<Us>();
+    if(fDifficulty > 900)
+        evaluation += EvaluateIsolatedPawns<Us>();
+    
+    constexpr float perspective = Us == Color::White ? 1. : -1.;
+    return evaluation * perspective;
+}
+
+template<Color Us>
 float Engine::EvaluateKingSafety() {
-    float eval = 0.0;
+    return EvaluateKingSafetyOf<Us>() - EvaluateKingSafetyOf<opposite(Us)>();
+}
 
-    const Color colorToMove = fBoard->GetColorToMove();
-    for(Color c : {Color::White, Color::Black}) {
-            // The king whose safety is being evaluated
-        const int isMover = c == colorToMove ? 1 : -1;
-        const U64 king = fBoard->GetBoard(c, Piece::King);
-        const U64 pawns = fBoard->GetBoard(c, Piece::Pawn);
-        bool kingInCorner = c == Color::White ? king & WHITE_KING_CORNERS : king & BLACK_KING_CORNERS;
-        // Count the number of pawns in front of a diaognally in front of the king
-        int nGuardingPawns = 0;
-        if(c == Color::White) {
-            nGuardingPawns = __builtin_popcountll(pawns & (north(king) | north_east(king) | north_west(king)));
-        } else {
-            nGuardingPawns = __builtin_popcountll(pawns & (south(king) | south_east(king) | south_west(king)));
-        }
-        if(fGamePhase < 0.5) {
-            // Early game reward kings that are safelty tucked in a corner behind the pawns
-            // Penalise kings running aimlessly around the board on a suicide mission
-            eval += isMover * (kingInCorner ? 10.0 : -10.0);
-            eval += isMover * (fPawnGuardKingEval[nGuardingPawns]);
-        } else {
-            // Reverse of the above is true for later game phases
-            eval += isMover * (kingInCorner ? -10.0 : 10.0);
-        }
+template<Color C>
+float Engine::EvaluateKingSafetyOf() {
+    float eval = 0.0;
+    const U64 king = fBoard->GetBoard(C, Piece::King);
+    const U64 pawns = fBoard->GetBoard(C, Piece::Pawn);
+    const bool kingInCorner = king & (C == Color::White ? WHITE_KING_CORNERS : BLACK_KING_CORNERS);
+    // Count the number of pawns in front of a diaognally in front of the king
+    const int nGuardingPawns = CountSetBits(pawns & (pawn_push<C>(king) | pawn_attacks<C>(king)));
+    if(fGamePhase < 0.5) {
+        // Early game reward kings that are safelty tucked in a corner behind the pawns
+        // Penalise kings running aimlessly around the board on a suicide mission
+        eval += kingInCorner ? 10.0 : -10.0;
+        eval += fPawnGuardKingEval[nGuardingPawns];
+    } else {
+        // Reverse of the above is true for later game phases
+        eval += kingInCorner ? -10.0 : 10.0;
     }
     return eval;
 }
 
+template<Color Us>
 float Engine::EvaluateBadBishops() {
-    float penalty = 0.0;
+    return EvaluateBadBishopsOf<Us>() - EvaluateBadBishopsOf<opposite(Us)>();
+}
 
-    const Color ctm = fBoard->GetColorToMove();
-    for(Color c : {Color::White, Color::Black}) {
-        const U64 allBishops = fBoard->GetBoard(c, Piece::Bishop);
-        U64 whiteBishops = allBishops & WHITE_SQUARES;
-        U64 blackBishops = allBishops & BLACK_SQUARES;
-        U64 pawns = fBoard->GetBoard(c, Piece::Pawn);
-        const int perspective = ctm == c ? 1 : -1;
+template<Color C>
+float Engine::EvaluateBadBishopsOf() {
+    float penalty = 0.0;
+    const U64 allBishops = fBoard->GetBoard(C, Piece::Bishop);
+    U64 whiteBishops = allBishops & WHITE_SQUARES;
+    U64 blackBishops = allBishops & BLACK_SQUARES;
+    U64 pawns = fBoard->GetBoard(C, Piece::Pawn);
 
-        // First search your white squared bishop
-        const int step = c == Color::Black ? 1 : -1;
-        const U8 maxRank = c == Color::Black ? 8 : 1;
-        int j = 0;
+    // First search your white squared bishop
+    constexpr int step = C == Color::Black ? 1 : -1;
+    constexpr U8 maxRank = C == Color::Black ? 8 : 1;
+    int j = 0;
 
-        for(U64 bishops : {whiteBishops, blackBishops}) {
+    for(U64 bishops : {whiteBishops, blackBishops}) {
         while(bishops) {
             const U64 bishop = 1ULL << __builtin_ctzll(bishops);
             const U64 rank = get_rank(bishop);
@@ -116,7 +118,7 @@ float Engine::EvaluateBadBishops() {
             for(int i = 1; rank <= abs(maxRank - rankNo); i += step) {
                 const U64 thisRank = RANKS[(rankNo + (i * step)) - 1];
                 while(thisRank & pawns & squares) { // Pawns on both sides can block the bishop
-                    penalty += (perspective * fBadBishopPawnRankAwayPenalty[i - 1]);
+                    penalty += fBadBishopPawnRankAwayPenalty[i - 1];
                     pawns &= pawns - 1;
                 }
             }
@@ -124,15 +126,15 @@ float Engine::EvaluateBadBishops() {
         }
         j++;
     }
-    }
 
     return penalty; // this will be a negative number
 }
 
+template<Color Us>
 float Engine::EvaluateIsolatedPawns() {
     float penalty = 0.0;
     int nIsolated = 0;
-    U64 myPawns = fBoard->GetBoard(Piece::Pawn);
+    U64 myPawns = fBoard->GetBoard(Us, Piece::Pawn);
     const U64 myPawnsStatic = myPawns;
     while(myPawns) {
         const U64 pawn = 1ULL << __builtin_ctzll(myPawns);
@@ -148,7 +150,7 @@ float Engine::EvaluateIsolatedPawns() {
 
     // To be fair you must also evaluate your opponents pawns in the same fashion
     nIsolated = 0;
-    U64 enemyPawns = fBoard->GetBoard(fBoard->GetColorToMove() == Color::White ? Color::Black : Color::White, Piece::Pawn);
+    U64 enemyPawns = fBoard->GetBoard(opposite(Us), Piece::Pawn);
     const U64 enemyPawnsStatic = enemyPawns;
     while(enemyPawns) {
         const U64 pawn = 1ULL << __builtin_ctzll(enemyPawns);
@@ -165,10 +167,11 @@ float Engine::EvaluateIsolatedPawns() {
     return penalty;
 }
 
+template<Color Us>
 float Engine::EvaluatePassedPawns() {
-    U64 myPawns = fBoard->GetBoard(Piece::Pawn);
-    U64 enemyPawns = fBoard->GetBoard(fOtherColor, Piece::Pawn);
-    U8 promotionRankNumber = fOtherColor == Color::Black ? 8 : 1;
+    U64 myPawns = fBoard->GetBoard(Us, Piece::Pawn);
+    U64 enemyPawns = fBoard->GetBoard(opposite(Us), Piece::Pawn);
+    U8 promotionRankNumber = Us == Color::White ? 8 : 1;
     float bonus = 0.0;
     while(myPawns) {
         const U64 pawn = 1ULL << __builtin_ctzll(myPawns);
@@ -177,7 +180,7 @@ float Engine::EvaluatePassedPawns() {
         passedMask |= (east(passedMask) | west(passedMask));
         // Now only allow ranks higher than yours in the defined attacking direction
         for(int iRank = 0; iRank < 8; ++iRank) {
-            if(fOtherColor == Color::Black) { // You are white
+            if constexpr(Us == Color::White) { // You are white
                 if(iRank <= rankNo - 1)
                     passedMask &= !RANKS[iRank];
             } else { // You are black
@@ -192,9 +195,9 @@ float Engine::EvaluatePassedPawns() {
         myPawns &= myPawns - 1;
     }
 
-    myPawns = fBoard->GetBoard(Piece::Pawn);
-    enemyPawns = fBoard->GetBoard(fOtherColor, Piece::Pawn);
-    promotionRankNumber = fOtherColor == Color::Black ? 1 : 8;
+    myPawns = fBoard->GetBoard(Us, Piece::Pawn);
+    enemyPawns = fBoard->GetBoard(opposite(Us), Piece::Pawn);
+    promotionRankNumber = Us == Color::White ? 1 : 8;
     while(enemyPawns) {
         const U64 pawn = 1ULL << __builtin_ctzll(enemyPawns);
         const U8 rankNo = get_rank_number(pawn);
@@ -202,7 +205,7 @@ float Engine::EvaluatePassedPawns() {
         passedMask |= (east(passedMask) | west(passedMask));
         // Now only allow ranks higher than yours in the defined attacking direction
         for(int iRank = 0; iRank < 8; ++iRank) {
-            if(fOtherColor == Color::Black) { // Enemy is black
+            if constexpr(Us == Color::White) { // Enemy is black
                 if(iRank <= rankNo - 1)
                     passedMask &= !RANKS[iRank];
             } else { // You are black
@@ -243,18 +246,14 @@ float Engine::ForceKingToCornerEndgame() {
 
 float Engine::GetMaterialEvaluation() {
     // Counts material and respects the position of the material e.g. knights in the centre are stronger
-    float material = 0.;
-    material += EvaluateKnightPositions();
-    material += EvaluateQueenPositions();
-    material += EvaluateRookPositions();
-    material += EvaluateBishopPositions();
+    // Knights, bishops, rooks and queens with their piece-square modifiers plus pawns, all kept up to date by the board
+    float material = fBoard->GetMaterialScore();
     //material += EvaluateKingPositions();
 
     //material += (__builtin_popcountll(fBoard->GetBoard(Color::White, Piece::Knight)) - __builtin_popcountll(fBoard->GetBoard(Color::Black, Piece::Knight))) * VALUE_PAWN;
     //material += (__builtin_popcountll(fBoard->GetBoard(Color::White, Piece::Bishop)) - __builtin_popcountll(fBoard->GetBoard(Color::Black, Piece::Bishop))) * VALUE_PAWN;
     //material += (__builtin_popcountll(fBoard->GetBoard(Color::White, Piece::Rook)) - __builtin_popcountll(fBoard->GetBoard(Color::Black, Piece::Rook))) * VALUE_PAWN;
     //material += (__builtin_popcountll(fBoard->GetBoard(Color::White, Piece::Queen)) - __builtin_popcountll(fBoard->GetBoard(Color::Black, Piece::Queen))) * VALUE_QUEEN;
-    material += (__builtin_popcountll(fBoard->GetBoard(Color::White, Piece::Pawn)) - __builtin_popcountll(fBoard->GetBoard(Color::Black, Piece::Pawn))) * VALUE_PAWN;
     return material;
 }
 
@@ -273,106 +272,49 @@ float Engine::EvaluateKingPositions() {
     return val;
 }
 
-float Engine::EvaluateKnightPositions() {
-    float val = 0.;
-    U64 white_knights = fBoard->GetBoard(Color::White, Piece::Knight);
-    U64 black_knights = fBoard->GetBoard(Color::Black, Piece::Knight);
-    while(white_knights) {
-        val += (VALUE_KNIGHT + fKnightPosModifier[__builtin_ctzll(white_knights)]);
-        white_knights &= white_knights - 1;
-    }
-    while(black_knights) {
-        val -= (VALUE_KNIGHT + fKnightPosModifier[__builtin_ctzll(black_knights)]);
-        black_knights &= black_knights - 1;
-    }
-    return val;
+void Engine::OrderMoves(MoveList &moves, const AttackInfo &info) {
+    for(int iMove = 0; iMove < moves.GetSize(); ++iMove)
+        moves.SetScore(iMove, MovePicker::ScoreMove(fBoard, moves[iMove], info.enemyPawnAttacks));
+    moves.SortByScore(); // Higher scores come first
 }
 
-float Engine::EvaluateQueenPositions() {
-    float val = 0.;
-    U64 white_queens = fBoard->GetBoard(Color::White, Piece::Queen);
-    U64 black_queens = fBoard->GetBoard(Color::Black, Piece::Queen);
-    while(white_queens) {
-        val += (VALUE_QUEEN + fQueenPosModifier[__builtin_ctzll(white_queens)]);
-        white_queens &= white_queens - 1;
-    }
-    while(black_queens) {
-        val -= (VALUE_QUEEN + fQueenPosModifier[__builtin_ctzll(black_queens)]);
-        black_queens &= black_queens - 1;
-    }
-    return val;
+void Engine::StoreKillerMove(const U16 move) {
+    const int ply = fBoard->GetNMoves() - fRootPly;
+    if(ply >= MAX_SEARCH_PLY || fKillerMoves[ply][0] == move)
+        return;
+    fKillerMoves[ply][1] = fKillerMoves[ply][0];
+    fKillerMoves[ply][0] = move;
 }
 
-float Engine::EvaluateRookPositions() {
-    float val = 0.;
-    U64 white_rooks = fBoard->GetBoard(Color::White, Piece::Rook);
-    U64 black_rooks = fBoard->GetBoard(Color::Black, Piece::Rook);
-    while(white_rooks) {
-        val += (VALUE_ROOK + fRookPosModifier[0][__builtin_ctzll(white_rooks)]);
-        white_rooks &= white_rooks - 1;
-    }
-    while(black_rooks) {
-        val -= (VALUE_ROOK + fRookPosModifier[1][__builtin_ctzll(black_rooks)]);
-        black_rooks &= black_rooks - 1;
-    }
-    return val;
+const U16* Engine::GetKillerMoves() {
+    static constexpr U16 noKillers[2] = {0, 0};
+    const int ply = fBoard->GetNMoves() - fRootPly;
+    return ply < MAX_SEARCH_PLY ? fKillerMoves[ply] : noKillers;
 }
 
-float Engine::EvaluateBishopPositions() {
-    float val = 0.;
-    U64 white_bishops = fBoard->GetBoard(Color::White, Piece::Bishop);
-    U64 black_bishops = fBoard->GetBoard(Color::Black, Piece::Bishop);
-    while(white_bishops) {
-        val += (VALUE_BISHOP + fBishopPosModifier[0][__builtin_ctzll(white_bishops)]);
-        white_bishops &= white_bishops - 1;
-    }
-    while(black_bishops) {
-        val -= (VALUE_BISHOP + fBishopPosModifier[1][__builtin_ctzll(black_bishops)]);
-        black_bishops &= black_bishops - 1;
-    }
-    return val;
+void Engine::MakeSearchMove(const U16 move, PositionSnapshot &snapshot) {
+    if(fCopyMake)
+        snapshot = fBoard->GetSnapshot();
+    fBoard->MakeMove(move);
 }
 
-void Engine::OrderMoves(std::vector<U16> &moves) {
-    const U64 pawnAttacks = fGenerator->GetPawnAttacks(fBoard, false);
-
-    std::sort(moves.begin(), moves.end(), [&](U16 move1, U16 move2) {
-        float move1ScoreEstimate = 0.;
-        float move2ScoreEstimate = 0.;
-        const int pieceType1 = (int)fBoard->GetMovePiece(move1);
-        const int takenPieceType1 = (int)fBoard->GetMoveTakenPiece(move1);
-        const int pieceType2 = (int)fBoard->GetMovePiece(move2);
-        const int takenPieceType2 = (int)fBoard->GetMoveTakenPiece(move2);
-
-        // Prioritise capturing opponent's most valuable pieces with our least valuable piece
-        if(takenPieceType1 != (int)Piece::Null)
-            move1ScoreEstimate += 10. * PIECE_VALUES[takenPieceType1] - PIECE_VALUES[pieceType1];
-        if(takenPieceType2 != (int)Piece::Null)
-            move2ScoreEstimate += 10. * PIECE_VALUES[takenPieceType2] - PIECE_VALUES[pieceType2];
-
-        // Promoting a pawn is probably a good plan
-        if(GetMoveIsPromotion(move1))
-            move1ScoreEstimate += PIECE_VALUES[(int)GetMovePromotionPiece(move1)];
-        if(GetMoveIsPromotion(move2))
-            move2ScoreEstimate += PIECE_VALUES[(int)GetMovePromotionPiece(move2)];
-        
-        // Penalize moving our pieces to a square attacked by an opponent pawn
-        if(pawnAttacks & GetMoveTarget(move1))
-            move1ScoreEstimate -= PIECE_VALUES[pieceType1];
-        if(pawnAttacks & GetMoveTarget(move2))
-            move2ScoreEstimate -= PIECE_VALUES[pieceType2];
-
-        return move1ScoreEstimate > move2ScoreEstimate; // Higher scores come first
-    });
+void Engine::UndoSearchMove(const PositionSnapshot &snapshot) {
+    if(fCopyMake) {
+        fBoard->LoadSnapshot(snapshot);
+    } else {
+        fBoard->UndoMove();
+    }
 }
 
 float Engine::SearchAllCaptures(float alpha, float beta, bool maximising) {
     // TODO: Should this extend the search for checks as well?
-    fGenerator->GenerateCaptureMoves(fBoard);
-    if(fGenerator->GetNCaptureMoves() == 0) // Nothing to search, return evaluation of the position
+    MoveList captureMoves;
+    fGenerator->GenerateCaptureMoves(fBoard, captureMoves);
+    // Captures that lose material once every recapture is played out are never worth searching
+    captureMoves.RemoveIf([this](const U16 move) { return fGenerator->GetStaticExchange(fBoard, move) < 0; });
+    if(captureMoves.GetSize() == 0) // Nothing to search, return evaluation of the position
         return Evaluate();
 
-    std::vector<U16> captureMoves = fGenerator->GetCaptureMoves(); // Get only capture moves
     //for(U16 move : captureMoves) {
     //    fBoard->PrintDetailedMove(move);
     //}
@@ -380,10 +322,11 @@ float Engine::SearchAllCaptures(float alpha, float beta, bool maximising) {
     if(maximising) {
         float maxEval = MIN_EVAL;
         for(U16 move : captureMoves) {
-            fBoard->MakeMove(move);
+            PositionSnapshot snapshot;
+            MakeSearchMove(move, snapshot);
             float evaluation = SearchAllCaptures(alpha, beta, false);
             fNMovesSearched++;
-            fBoard->UndoMove();
+            UndoSearchMove(snapshot);
             maxEval = std::max(maxEval, evaluation); // White picks the move which maximises the score
             alpha = std::max(alpha, evaluation);
             if(beta <= alpha) // Prune the branch
@@ -393,10 +336,11 @@ float Engine::SearchAllCaptures(float alpha, float beta, bool maximising) {
     } else {
         float minEval = MAX_EVAL;
         for(U16 move : captureMoves) {
-            fBoard->MakeMove(move);
+            PositionSnapshot snapshot;
+            MakeSearchMove(move, snapshot);
             float evaluation = SearchAllCaptures(alpha, beta, true);
             fNMovesSearched++;
-            fBoard->UndoMove();
+            UndoSearchMove(snapshot);
             minEval = std::min(minEval, evaluation); // White picks the move which maximises the score
             beta = std::min(beta, evaluation);
             if(beta <= alpha) // Prune the branch
@@ -406,7 +350,37 @@ float Engine::SearchAllCaptures(float alpha, float beta, bool maximising) {
     }
 }
 
-float Engine::Search(U8 depth, float alpha, float beta, bool maximising) {
+bool Engine::TryNullMovePruning(U8 depth, float alpha, float beta, bool maximising, bool inCheck, float &evaluation) {
+    // Can't beat an infinite bound, and passing while in check is illegal
+    if(depth < NULL_MOVE_MIN_DEPTH || (maximising ? beta >= MAX_EVAL : alpha <= MIN_EVAL))
+        return false;
+    const Color movingColor = fBoard->GetColorToMove();
+    // With only king and pawns left zugzwang is likely so passing would overestimate the position
+    if(!(fBoard->GetBoard(movingColor) & ~fBoard->GetBoard(movingColor, Piece::Pawn) & ~fBoard->GetBoard(movingColor, Piece::King)))
+        return false;
+    if(inCheck)
+        return false;
+
+    // Null window search around the bound we are trying to beat
+    const float nullAlpha = maximising ? std::nextafter(beta, MIN_EVAL) : alpha;
+    const float nullBeta = maximising ? beta : std::nextafter(alpha, MAX_EVAL);
+    fBoard->MakeNullMove();
+    evaluation = Search(depth - 1 - NULL_MOVE_REDUCTION, nullAlpha, nullBeta, !maximising, false);
+    fBoard->UndoNullMove();
+    if(maximising ? evaluation < beta : evaluation > alpha)
+        return false;
+
+    // Confirm the cut off with a reduced search without passing when zugzwang is plausible
+    if(fBoard->GetGamePhase() > NULL_MOVE_VERIFY_PHASE) {
+        evaluation = Search(depth - NULL_MOVE_REDUCTION, nullAlpha, nullBeta, maximising, false);
+        if(maximising ? evaluation < beta : evaluation > alpha)
+            return false;
+    }
+    evaluation = maximising ? beta : alpha;
+    return true;
+}
+
+float Engine::Search(U8 depth, float alpha, float beta, bool maximising, bool allowNullMove) {
     if(depth == 0) {
         fNMovesSearched++;
         //float x = SearchAllCaptures(alpha, beta, maximising);
@@ -415,46 +389,52 @@ float Engine::Search(U8 depth, float alpha, float beta, bool maximising) {
         return x; //SearchAllCaptures(alpha, beta, maximising);
     }
 
-    fGenerator->GenerateLegalMoves(fBoard);
-    if(fGenerator->GetNLegalMoves() == 0) { // No need to search we are at the end of the game tree on this branch
+    // Every move made in search stays on the board's undo stack, so repeats inside the tree are seen too
+    if(fBoard->IsRepetition(1))
+        return 0.0f;
+
+    // Checkers, pins and enemy attacks are worked out once here and shared by null-move pruning and every picker stage
+    AttackInfo info;
+    fGenerator->UpdateAttackInfo(fBoard, info);
+
+    float nullMoveEvaluation;
+    if(allowNullMove && TryNullMovePruning(depth, alpha, beta, maximising, info.checkers, nullMoveEvaluation))
+        return nullMoveEvaluation;
+
+    // Moves come out in stages, a cut off by an early capture or killer skips generating the rest
+    MovePicker picker(fGenerator, fBoard, info, GetKillerMoves());
+    int nMoves = 0;
+    float bestEval = maximising ? MIN_EVAL : MAX_EVAL;
+    for(U16 move = picker.GetNextMove(); move; move = picker.GetNextMove()) {
+        nMoves++;
+        PositionSnapshot snapshot;
+        MakeSearchMove(move, snapshot);
+        float evaluation = Search(depth - 1, alpha, beta, !maximising);
+        UndoSearchMove(snapshot);
+        if(maximising) {
+            bestEval = std::max(bestEval, evaluation); // White picks the move which maximises the score
+            alpha = std::max(alpha, evaluation);
+        } else {
+            bestEval = std::min(bestEval, evaluation); // Black picks the move which minimises the score
+            beta = std::min(beta, evaluation);
+        }
+        if(beta <= alpha) { // Prune the branch
+            if(picker.GetIsQuiet())
+                StoreKillerMove(move);
+            break;
+        }
+    }
+
+    if(nMoves == 0) { // No legal moves so we are at the end of the game tree on this branch
         const Color movingColor = fBoard->GetColorToMove(); // Who has 0 legal moves remaining
-        const Color otherColor = movingColor == Color::White ? Color::Black : Color::White;
-        const bool inCheck = fGenerator->IsUnderAttack(fBoard->GetBoard(movingColor, Piece::King), otherColor, fBoard);
+        const bool inCheck = info.checkers;
         if(inCheck) { // No legal moves and you are in check(mate) so negative infinity in correct "direction"
             return movingColor == Color::White ? MIN_EVAL : MAX_EVAL; 
         } else { // Must be a stalemate - so completely even position
             return 0.0f;
         }
     }
-
-    std::vector<U16> moves = fGenerator->GetLegalMoves();
-    if(maximising) {
-        float maxEval = MIN_EVAL;
-        for(U16 move : moves) {
-            fBoard->MakeMove(move);
-            float evaluation = Search(depth - 1, alpha, beta, false);
-            fBoard->UndoMove();
-            maxEval = std::max(maxEval, evaluation); // White picks the move which maximises the score
-            alpha = std::max(alpha, evaluation);
-            if(beta <= alpha) { // Prune the branch
-                break;
-            }
-        }
-        return maxEval;
-    } else {
-        float minEval = MAX_EVAL;
-        for(U16 move : moves) {
-            fBoard->MakeMove(move);
-            float evaluation = Search(depth - 1, alpha, beta, true);
-            fBoard->UndoMove();
-            minEval = std::min(minEval, evaluation); // Black picks the move which minimises the score
-            beta = std::min(beta, evaluation);
-            if(beta <= alpha) {// Prune the branch
-                break;
-            }
-        }
-        return minEval;
-    }
+    return bestEval;
 }
 
 U16 Engine::GetBestMove(const bool verbose) {
@@ -467,13 +447,16 @@ U16 Engine::GetBestMove(const bool verbose) {
     fNHashesFound = 0;
 
     // Get the legal moves that we have to choose from (i.e. depth = 1 moves)
-    std::vector<U16> primaryMoves = fGenerator->GetLegalMoves();
-    if(primaryMoves.size() == 1) {
-        return primaryMoves.at(0);
+    AttackInfo info;
+    fGenerator->UpdateAttackInfo(fBoard, info);
+    MoveList primaryMoves;
+    fGenerator->GenerateLegalMoves(fBoard, info, primaryMoves);
+    if(primaryMoves.GetSize() == 1) {
+        return primaryMoves[0];
     }
 
     // Order moves to speed up alpha-beta pruning
-    OrderMoves(primaryMoves);
+    OrderMoves(primaryMoves, info);
 
     // Must take into account colour such that more negative values are better for black
     Color colorToMove = fBoard->GetColorToMove();
@@ -481,14 +464,17 @@ U16 Engine::GetBestMove(const bool verbose) {
     float alpha0 = MIN_EVAL; // Opposite as 1 ply from first for loop
     float beta0 = MAX_EVAL; // Opposite as 1 ply from first for loop
     fNMovesSearched = 0;
+    fRootPly = fBoard->GetNMoves();
+    std::fill(&fKillerMoves[0][0], &fKillerMoves[0][0] + MAX_SEARCH_PLY * 2, U16(0));
 
     // This primary for loop accounts for 1 level of depth
     for(U16 primaryMove : primaryMoves) {
-        fBoard->MakeMove(primaryMove);
+        PositionSnapshot snapshot;
+        MakeSearchMove(primaryMove, snapshot);
         // Find the evaluation up to a specified depth using the minimax search algorithm
         // opposite way round as 1 ply of search already accounted for by this loop
         float evaluation = Search(fMaxDepth - 1, alpha0, beta0, colorToMove == Color::White ? false : true);
-        fBoard->UndoMove();
+        UndoSearchMove(snapshot);
         if((evaluation > bestEvaluation && colorToMove == Color::White) ||
             evaluation < bestEvaluation && colorToMove == Color::Black) {
             bestEvaluation = evaluation;
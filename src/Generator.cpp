@@ -1,116 +1,240 @@
 #include "Generator.hpp"
 
 Generator::Generator() {
-    GenerateAttackTables();
+    InitMagics();
 }
 
-void Generator::GenerateAttackTables() {
-    for(int iSquare = 0; iSquare < NSQUARES; ++iSquare) {
-        U64 position = 1ULL << iSquare;
-        FillKingAttackTable(position);
-        FillKnightAttackTable(position);
-        FillPawnAttackTable(position);
-        FillStraightAttackTables(position);
-        FillDiagonalAttackTables(position);
-    }
+void Generator::GenerateCaptureMoves(const std::shared_ptr<Board> &board, const AttackInfo &info, MoveList &moves) const {
+    moves.Clear();
+    if(CheckDraw(board))
+        return;
+    Generate<MoveGenType::Captures>(board, info, moves);
 }
 
-void Generator::FillKingAttackTable(const U64 pos) {
-    fKingAttacks[__builtin_ctzll(pos)] = north(pos) | east(pos) | west(pos) | south(pos) | north_east(pos) | north_west(pos) | south_east(pos) | south_west(pos);
+void Generator::GenerateQuietMoves(const std::shared_ptr<Board> &board, const AttackInfo &info, MoveList &moves) const {
+    moves.Clear();
+    if(CheckDraw(board))
+        return;
+    Generate<MoveGenType::Quiets>(board, info, moves);
 }
 
-void Generator::FillKnightAttackTable(const U64 pos) {
-    fKnightAttacks[__builtin_ctzll(pos)] = north(north_east(pos)) | north(north_west(pos)) | south(south_east(pos)) | south(south_west(pos)) | east(north_east(pos)) | east(south_east(pos)) | west(north_west(pos)) | west(south_west(pos));
+void Generator::GenerateEvasionMoves(const std::shared_ptr<Board> &board, const AttackInfo &info, MoveList &moves) const {
+    moves.Clear();
+    if(CheckDraw(board))
+        return;
+    Generate<MoveGenType::Evasions>(board, info, moves);
 }
 
-void Generator::FillPawnAttackTable(const U64 pos) {
-    // Note this does not include special pawn moves like en-passant or promotion
-    U64 attacks = 0;
-    const U8 lsb = __builtin_ctzll(pos);
-    // White pawn case (attacks in a northern direction)
-    attacks |= north(pos);
-    if(pos & RANK_2)
-        attacks |= north(north(pos)); // Assumes nothing blocking the pawns path
-    fWhitePawnForwardAttacks[lsb] = attacks;
-    // Only valid when occupied by enemy piece as these are taking moves
-    fWhitePawnDiagonalAttacks[lsb] = north_east(pos) | north_west(pos);
+void Generator::GenerateQuietCheckMoves(const std::shared_ptr<Board> &board, const AttackInfo &info, MoveList &moves) const {
+    moves.Clear();
+    if(CheckDraw(board))
+        return;
+    Generate<MoveGenType::QuietChecks>(board, info, moves);
+}
 
-    attacks = 0; // Now case for the black pawn attacking in a southern direction
-    attacks |= south(pos);
-    if(pos & RANK_7)
-        attacks |= south(south(pos));
-    fBlackPawnForwardAttacks[lsb] = attacks;
-    fBlackPawnDiagonalAttacks[lsb] = south_east(pos) | south_west(pos);
+void Generator::UpdateAttackInfo(const std::shared_ptr<Board> &board, AttackInfo &info) const {
+    if(board->GetColorToMove() == Color::White) {
+        UpdateAttackInfo<Color::White>(board, info);
+    } else {
+        UpdateAttackInfo<Color::Black>(board, info);
+    }
+}
+
+bool Generator::IsInCheck(const std::shared_ptr<Board> &board) const {
+    const Color color = board->GetColorToMove();
+    const U8 kingLSB = __builtin_ctzll(board->GetBoard(color, Piece::King));
+    return GetAttackersTo(board, kingLSB, board->GetOccupancy()) & board->GetBoard(opposite(color));
+}
+
+U64 Generator::GetAttackersTo(const std::shared_ptr<Board> &board, const U8 square, const U64 occupancy) const {
+    const U64 queens = board->GetBoard(Color::White, Piece::Queen) | board->GetBoard(Color::Black, Piece::Queen);
+    const U64 bishops = board->GetBoard(Color::White, Piece::Bishop) | board->GetBoard(Color::Black, Piece::Bishop) | queens;
+    const U64 rooks = board->GetBoard(Color::White, Piece::Rook) | board->GetBoard(Color::Black, Piece::Rook) | queens;
+    // A piece attacks the square exactly when the same piece on the square would attack it, a white pawn attacks it from
+    // where a black pawn on the square would capture
+    return (ATTACK_TABLES.pawn[(int)Color::Black][square] & board->GetBoard(Color::White, Piece::Pawn)) |
+        (ATTACK_TABLES.pawn[(int)Color::White][square] & board->GetBoard(Color::Black, Piece::Pawn)) |
+        (ATTACK_TABLES.knight[square] & (board->GetBoard(Color::White, Piece::Knight) | board->GetBoard(Color::Black, Piece::Knight))) |
+        (ATTACK_TABLES.king[square] & (board->GetBoard(Color::White, Piece::King) | board->GetBoard(Color::Black, Piece::King))) |
+        (GetBishopAttacks(square, occupancy) & bishops) |
+        (GetRookAttacks(square, occupancy) & rooks);
+}
+
+int Generator::GetStaticExchange(const std::shared_ptr<Board> &board, const U16 move) const {
+    if(GetMoveIsCastling(move))
+        return 0;
+
+    constexpr Piece byValue[6] = {Piece::Pawn, Piece::Knight, Piece::Bishop, Piece::Rook, Piece::Queen, Piece::King};
+    const U8 from = move & ORIGIN_MASK;
+    const U8 to = (move & TARGET_MASK) >> 6;
+    const U64 origin = 1ULL << from;
+    const U64 target = 1ULL << to;
+    Piece moving = board->GetMovePiece(move);
+    const Color mover = board->GetIsOccupied(origin).first;
+
+    int gain[32]; // Swap list, gain[d] is the balance for the side capturing at depth d if the exchange stopped there
+    gain[0] = (int)PIECE_VALUES[(int)board->GetMoveTakenPiece(move)];
+    U64 occupancy = board->GetOccupancy() ^ origin;
+    if(GetMoveIsEnPassant(move)) {
+        gain[0] = (int)VALUE_PAWN; // En-passant, the taken pawn is beside the target not on it
+        occupancy ^= get_rank(origin) & get_file(target);
+    }
+    if(GetMoveIsPromotion(move)) {
+        moving = GetMovePromotionPiece(move);
+        gain[0] += (int)(PIECE_VALUES[(int)moving] - VALUE_PAWN);
+    }
+
+    const U64 diagonalSliders = board->GetBoard(Color::White, Piece::Bishop) | board->GetBoard(Color::Black, Piece::Bishop) |
+        board->GetBoard(Color::White, Piece::Queen) | board->GetBoard(Color::Black, Piece::Queen);
+    const U64 straightSliders = board->GetBoard(Color::White, Piece::Rook) | board->GetBoard(Color::Black, Piece::Rook) |
+        board->GetBoard(Color::White, Piece::Queen) | board->GetBoard(Color::Black, Piece::Queen);
+    U64 attackers = GetAttackersTo(board, to, occupancy) & occupancy;
+    Color side = opposite(mover);
+    int depth = 0;
+    while(true) {
+        // Find the least valuable piece of the side to recapture
+        U64 sideAttackers = attackers & board->GetBoard(side);
+        if(!sideAttackers)
+            break;
+        Piece capturer = Piece::Null;
+        U64 capturerBit = 0;
+        for(Piece p : byValue) {
+            const U64 candidates = sideAttackers & board->GetBoard(side, p);
+            if(candidates) {
+                capturer = p;
+                capturerBit = candidates & -candidates;
+                break;
+            }
+        }
+
+        depth++;
+        gain[depth] = (int)PIECE_VALUES[(int)moving] - gain[depth - 1]; // Take the piece that last moved onto the square
+        if(std::max(-gain[depth - 1], gain[depth]) < 0) { // Capturing can't save this side, the sign of the result is settled
+            depth--;
+            break;
+        }
+
+        // Removing the capturer may open a sliding ray from behind it onto the square
+        occupancy ^= capturerBit;
+        attackers |= (GetBishopAttacks(to, occupancy) & diagonalSliders) | (GetRookAttacks(to, occupancy) & straightSliders);
+        attackers &= occupancy;
+        moving = capturer;
+        side = opposite(side);
+        if(capturer == Piece::King && (attackers & board->GetBoard(side))) { // The king can't capture into a defended square
+            depth--;
+            break;
+        }
+    }
+
+    // Each side picks the better of capturing and stopping, working back from the end of the exchange
+    while(depth > 0) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+    return gain[0];
 }
 
-void Generator::FillStraightAttackTables(const U64 pos) {
-    U8 lsb = __builtin_ctzll(pos);
-    fPrimaryStraightAttacks[lsb] = get_rank(pos) ^ pos;
-    fSecondaryStraightAttacks[lsb] = get_file(pos) ^ pos;
+bool Generator::IsPseudoLegal(const std::shared_ptr<Board> &board, const AttackInfo &info, const U16 move) const {
+    if(board->GetColorToMove() == Color::White)
+        return IsPseudoLegal<Color::White>(board, info, move);
+    return IsPseudoLegal<Color::Black>(board, info, move);
 }
 
-void Generator::FillDiagonalAttackTables(const U64 pos) {
-    // Vertical distance from primary diagonal is just abs(x - y) (zero indexed)
-    // negative value = shift primary DOWN, positive value = shift primary UP
-    const U8 fileNumber = get_file_number(pos);
-    const U8 rankNumber = get_rank_number(pos);
-    const U8 lsb = __builtin_ctzll(pos);
+template<Color C>
+bool Generator::IsPseudoLegal(const std::shared_ptr<Board> &board, const AttackInfo &state, const U16 move) const {
+    constexpr bool white = C == Color::White;
+    constexpr U64 startRank = white ? RANK_2 : RANK_7;
+    constexpr U64 promotionRank = white ? RANK_8 : RANK_1;
+    const U16 flag = GetMoveFlag(move);
+    const U8 from = move & ORIGIN_MASK;
+    const U64 origin = 1ULL << from;
+    const U64 target = GetMoveTarget(move);
 
-    const int dPrimaryDiag = (fileNumber - 1) - (8 - rankNumber); // Vertical distance from the primary diagonal
-    const int dSecondaryDiag = (8 - fileNumber) - (8 - rankNumber); // Vertical distance from the secondary diagonal
+    // One of our pieces must move off its square onto one free of our pieces, taking a piece exactly when flagged to
+    if(!(origin & board->GetBoard(C)) || (target & board->GetBoard(C)))
+        return false;
+    if(flag == MOVE_EN_PASSANT ? target != board->GetEnPassantSquare() : GetMoveIsCapture(move) != (bool)(target & state.enemy))
+        return false;
 
-    U64 primaryAttacks = dPrimaryDiag > 0 ? PRIMARY_DIAGONAL << (abs(dPrimaryDiag) * 8) : PRIMARY_DIAGONAL >> (abs(dPrimaryDiag) * 8);
-    U64 secondaryAttacks = dSecondaryDiag > 0 ? SECONDARY_DIAGONAL << (abs(dSecondaryDiag) * 8) : SECONDARY_DIAGONAL >> (abs(dSecondaryDiag) * 8);
+    if(GetMoveIsCastling(move)) {
+        if(origin != state.king || state.checkers)
+            return false;
+        const U8 rights = board->GetCastlingRights();
+        if(flag == MOVE_KING_CASTLE)
+            return target == (white ? SQUARE_G1 : SQUARE_G8) && (rights & (white ? CASTLING_WHITE_KINGSIDE : CASTLING_BLACK_KINGSIDE)) &&
+                IsCastlingPossible(state, white ? KING_SIDE_CASTLING_MASK_WHITE : KING_SIDE_CASTLING_MASK_BLACK,
+                    white ? KING_SIDE_CASTLING_OCCUPANCY_MASK_WHITE : KING_SIDE_CASTLING_OCCUPANCY_MASK_BLACK);
+        return target == (white ? SQUARE_C1 : SQUARE_C8) && (rights & (white ? CASTLING_WHITE_QUEENSIDE : CASTLING_BLACK_QUEENSIDE)) &&
+            IsCastlingPossible(state, white ? QUEEN_SIDE_CASTLING_MASK_WHITE : QUEEN_SIDE_CASTLING_MASK_BLACK,
+                white ? QUEEN_SIDE_CASTLING_OCCUPANCY_MASK_WHITE : QUEEN_SIDE_CASTLING_OCCUPANCY_MASK_BLACK);
+    }
+
+    const Piece piece = board->GetMovePiece(move);
+    if(piece == Piece::Pawn) {
+        // Pawns promote exactly when reaching the last rank, the promotion piece bits play no part in where they may go
+        if(GetMoveIsPromotion(move) != (bool)(target & promotionRank))
+            return false;
+        const U16 type = GetMoveIsPromotion(move) ? flag & MOVE_PROMOTION_CAPTURE : flag;
+        if(type == MOVE_CAPTURE || type == MOVE_EN_PASSANT || type == MOVE_PROMOTION_CAPTURE) {
+            if(!(ATTACK_TABLES.pawn[(int)C][from] & target))
+                return false;
+        } else if(type == MOVE_DOUBLE_PUSH) {
+            if(!(origin & startRank) || target != pawn_push<C>(pawn_push<C>(origin)) || (pawn_push<C>(origin) & state.occupancy))
+                return false;
+        } else if(type != MOVE_QUIET && type != MOVE_PROMOTION) {
+            return false;
+        } else if(target != pawn_push<C>(origin)) {
+            return false;
+        }
+    } else {
+        // Only pawns push twice, take en-passant or promote
+        if(flag != MOVE_QUIET && flag != MOVE_CAPTURE)
+            return false;
+        U64 attacks = 0;
+        switch(piece) {
+            case Piece::Knight: attacks = GetPieceAttacks<Piece::Knight>(from, state.occupancy); break;
+            case Piece::Bishop: attacks = GetPieceAttacks<Piece::Bishop>(from, state.occupancy); break;
+            case Piece::Rook: attacks = GetPieceAttacks<Piece::Rook>(from, state.occupancy); break;
+            case Piece::Queen: attacks = GetPieceAttacks<Piece::Queen>(from, state.occupancy); break;
+            case Piece::King: attacks = ATTACK_TABLES.king[from]; break;
+            default: break;
+        }
+        if(!(attacks & target))
+            return false;
+    }
 
-    fPrimaryDiagonalAttacks[lsb] = primaryAttacks ^ pos;
-    fSecondaryDiagonalAttacks[lsb] = secondaryAttacks ^ pos;
+    // In check anything but the king must take the lone checker or block it, the check mask is empty in double check
+    if(piece == Piece::King)
+        return true;
+    const U64 landing = flag == MOVE_EN_PASSANT ? target | pawn_push<opposite(C)>(target) : target;
+    return landing & state.checkMask;
 }
 
-void Generator::GenerateCaptureMoves(const std::shared_ptr<Board> &board) {
-    fCaptureMoves.clear();
-    if(CheckFiftyMoveDraw(board))
-        return;
-    if(CheckInsufficientMaterial(board))
-        return;
-    if(CheckMoveRepitition(board))
-        return;
-
-    fColor = board->GetColorToMove();
-    fOtherColor = fColor == Color::White ? Color::Black : Color::White;
-    fOccupancy = board->GetOccupancy();
-    fEnemy = board->GetBoard(fOtherColor);
-    fKing = board->GetBoard(fColor, Piece::King);
-    fCaptureMoves.reserve(10);
+bool Generator::IsLegal(const std::shared_ptr<Board> &board, const AttackInfo &info, const U16 move) const {
+    const U8 from = move & ORIGIN_MASK;
+    const U64 target = GetMoveTarget(move);
 
-    // Doesn't generate castling (this is not a capture)
-    GeneratePseudoLegalCaptureMoves(board);
-    GenerateEnPassantCaptureMoves(board);
-    RemoveIllegalCaptureMoves(board);
+    // The enemy attacks are worked out without our king on the board, so it can't step back along a checking ray either.
+    // Castling has had its whole path checked already
+    if(info.king & (1ULL << from))
+        return GetMoveIsCastling(move) || !(target & info.enemyAttacks);
+    if(GetMoveIsEnPassant(move)) {
+        if(board->GetColorToMove() == Color::White)
+            return GetEnPassantIsLegal<Color::White>(board, info, 1ULL << from, target);
+        return GetEnPassantIsLegal<Color::Black>(board, info, 1ULL << from, target);
+    }
+    return target & GetPinRay(info, from);
 }
 
-void Generator::GenerateLegalMoves(const std::shared_ptr<Board> &board) { // TODO: Make me multi-threaded?
-    fLegalMoves.clear();
-    if(CheckFiftyMoveDraw(board))
-        return;
-    if(CheckInsufficientMaterial(board))
-        return;
-    if(CheckMoveRepitition(board))
+void Generator::GenerateLegalMoves(const std::shared_ptr<Board> &board, const AttackInfo &info, MoveList &moves) const {
+    moves.Clear();
+    if(CheckDraw(board))
         return;
 
-    fColor = board->GetColorToMove();
-    fOtherColor = fColor == Color::White ? Color::Black : Color::White;
-    fOccupancy = board->GetOccupancy();
-    fKing = board->GetBoard(fColor, Piece::King);
-    fLegalMoves.reserve(AVERAGE_MOVES_PER_POSITION); // Avoid excess dynamic memory allocation
+    Generate<MoveGenType::All>(board, info, moves);
 
-    GeneratePseudoLegalMoves(board);
-    GenerateCastlingMoves(board);
-    GenerateEnPassantMoves(board);
-    RemoveIllegalMoves(board);
-
-    if(fLegalMoves.size() == 0) { // No legal moves, game is either stalemate or checkmate
-        bool kingInCheck = IsUnderAttack(fKing, fOtherColor, board);
-        if(kingInCheck) {
+    if(moves.GetSize() == 0) { // No legal moves, game is either stalemate or checkmate
+        if(info.checkers) {
             board->SetState(State::Checkmate);
         } else {
             board->SetState(State::Stalemate);
@@ -118,24 +242,102 @@ void Generator::GenerateLegalMoves(const std::shared_ptr<Board> &board) { // TOD
     }
 }
 
-bool Generator::CheckMoveRepitition(const std::shared_ptr<Board> &board) {
-    std::unordered_map<U64, int> countMap; // Map to store count of each hash
-    // Count occurrences of each element in the vector
-    for (U64 elem : board->GetHistory()) {
-        countMap[elem]++;
+template<MoveGenType T>
+void Generator::Generate(const std::shared_ptr<Board> &board, const AttackInfo &state, MoveList &moves) const {
+    if(board->GetColorToMove() == Color::White) {
+        GenerateMoves<Color::White, T>(board, state, moves);
+    } else {
+        GenerateMoves<Color::Black, T>(board, state, moves);
+    }
+}
+
+template<Color C, MoveGenType T>
+void Generator::GenerateMoves(const std::shared_ptr<Board> &board, const AttackInfo &state, MoveList &moves) const {
+    if constexpr(T == MoveGenType::Evasions || T == MoveGenType::All) {
+        if(state.checkers) {
+            GenerateEvasions<C>(board, state, moves);
+            return;
+        }
+        if constexpr(T == MoveGenType::Evasions)
+            return;
+    } else if constexpr(T == MoveGenType::QuietChecks) {
+        if(!state.checkers)
+            GenerateQuietChecks<C>(board, state, moves);
+        return;
     }
 
-    // Check if any element appears three or more times
-    for (const auto& pair : countMap) {
-        if (pair.second >= 3) {
-            board->SetState(State::MoveRepetition);
-            return true; // Board has met conditions for move repitition, game is a draw
+    if constexpr(T == MoveGenType::Captures) {
+        // Doesn't generate castling (this is not a capture)
+        GeneratePieceMoves<C>(board, state, state.enemy, moves);
+    } else if constexpr(T == MoveGenType::Quiets) {
+        GeneratePieceMoves<C>(board, state, ~state.occupancy, moves);
+    } else {
+        GeneratePieceMoves<C>(board, state, ~board->GetBoard(C), moves);
+    }
+    if constexpr(T != MoveGenType::Captures)
+        GenerateCastlingMoves<C>(board, state, moves);
+    if constexpr(T != MoveGenType::Quiets)
+        GenerateEnPassantMoves<C>(board, state, moves);
+}
+
+template<Color C>
+void Generator::UpdateAttackInfo(const std::shared_ptr<Board> &board, AttackInfo &state) const {
+    constexpr Color them = opposite(C);
+    state.occupancy = board->GetOccupancy();
+    state.enemy = board->GetBoard(them);
+    state.king = board->GetBoard(C, Piece::King);
+
+    const U8 kingLSB = __builtin_ctzll(state.king);
+    const U64 enemyQueens = board->GetBoard(them, Piece::Queen);
+    const U64 diagonalSliders = board->GetBoard(them, Piece::Bishop) | enemyQueens;
+    const U64 straightSliders = board->GetBoard(them, Piece::Rook) | enemyQueens;
+
+    // A piece attacks the king exactly when the same piece on the king's square would attack it
+    state.checkers = (ATTACK_TABLES.pawn[(int)C][kingLSB] & board->GetBoard(them, Piece::Pawn)) |
+        (ATTACK_TABLES.knight[kingLSB] & board->GetBoard(them, Piece::Knight)) |
+        (GetBishopAttacks(kingLSB, state.occupancy) & diagonalSliders) |
+        (GetRookAttacks(kingLSB, state.occupancy) & straightSliders);
+
+    if(!state.checkers) {
+        state.checkMask = ~0ULL;
+    } else if(state.checkers & (state.checkers - 1)) {
+        state.checkMask = 0; // Double check, only the king may move
+    } else {
+        state.checkMask = state.checkers | ATTACK_TABLES.between[kingLSB][__builtin_ctzll(state.checkers)];
+    }
+
+    // Sliders sharing a line with the king pin the only piece in the way if it is one of ours
+    state.pinned = 0;
+    const U64 friendly = board->GetBoard(C);
+    U64 pinners = (ATTACK_TABLES.bishop[kingLSB] & diagonalSliders) | (ATTACK_TABLES.rook[kingLSB] & straightSliders);
+    while(pinners) {
+        const U8 pinnerLSB = __builtin_ctzll(pinners);
+        const U64 blockers = ATTACK_TABLES.between[kingLSB][pinnerLSB] & state.occupancy;
+        if(blockers && !(blockers & (blockers - 1)) && (blockers & friendly)) {
+            state.pinned |= blockers;
+            state.pinRays[__builtin_ctzll(blockers)] = ATTACK_TABLES.between[kingLSB][pinnerLSB] | (1ULL << pinnerLSB);
         }
+        pinners &= pinners - 1;
+    }
+
+    state.enemyPawnAttacks = pawn_attacks<them>(board->GetBoard(them, Piece::Pawn));
+    // Lift the king off the board so sliders checking it also cover the squares behind it
+    state.enemyAttacks = GetAttacks<them>(board, state.occupancy ^ state.king);
+}
+
+bool Generator::CheckDraw(const std::shared_ptr<Board> &board) const {
+    return CheckFiftyMoveDraw(board) || CheckInsufficientMaterial(board) || CheckMoveRepitition(board);
+}
+
+bool Generator::CheckMoveRepitition(const std::shared_ptr<Board> &board) const {
+    if(board->IsRepetition(2)) { // Current position plus two earlier occurrences
+        board->SetState(State::MoveRepetition);
+        return true; // Board has met conditions for move repitition, game is a draw
     }
     return false;
 }
 
-bool Generator::CheckFiftyMoveDraw(const std::shared_ptr<Board> &board) {
+bool Generator::CheckFiftyMoveDraw(const std::shared_ptr<Board> &board) const {
     if(board->GetHalfMoveClock() == 100) {
         board->SetState(State::FiftyMoveRule);
         return true;
@@ -143,7 +345,7 @@ bool Generator::CheckFiftyMoveDraw(const std::shared_ptr<Board> &board) {
     return false;
 }
 
-bool Generator::CheckInsufficientMaterial(const std::shared_ptr<Board> &board) {
+bool Generator::CheckInsufficientMaterial(const std::shared_ptr<Board> &board) const {
     const U8 nBlackPieces = CountSetBits(board->GetBoard(Color::Black));
     const U8 nWhitePieces = CountSetBits(board->GetBoard(Color::White));
     if(nBlackPieces > 2 || nWhitePieces > 2)
@@ -164,706 +366,368 @@ bool Generator::CheckInsufficientMaterial(const std::shared_ptr<Board> &board) {
     return false;
 }
 
-void Generator::GeneratePseudoLegalCaptureMoves(const std::shared_ptr<Board> &board) {
-    // King
-    U64 kingAttacks = fKingAttacks[__builtin_ctzll(fKing)] & fEnemy;
-    while(kingAttacks) {
-        const U64 attack = 1ULL << __builtin_ctzll(kingAttacks);
-        U16 move = 0;
-        SetMove(move, fKing, attack);
-        fCaptureMoves.push_back(move);
-        kingAttacks &= kingAttacks - 1; // Clear the lowest set bit
-    }
+template<Color C>
+void Generator::GenerateEvasions(const std::shared_ptr<Board> &board, const AttackInfo &state, MoveList &moves) const {
+    GenerateKingMoves(state, ~board->GetBoard(C), moves);
+    if(state.checkers & (state.checkers - 1)) // Double check, only the king may move
+        return;
 
-    // Knight
-    U64 knights = board->GetBoard(fColor, Piece::Knight);
-    while(knights) {
-        const U8 lsb = __builtin_ctzll(knights);
-        const U64 knight = 1ULL << lsb;
-        U64 attacks = fKnightAttacks[lsb] & fEnemy;
-        while(attacks) {
-            const U64 attack = 1ULL << __builtin_ctzll(attacks);
-            U16 move = 0;
-            SetMove(move, knight, attack);
-            fCaptureMoves.push_back(move);
-            attacks &= attacks - 1; // Clear the lowest set bit
-        }
-        knights &= knights - 1;
+    // Anything else must take the checker or step in between it and the king
+    GeneratePawnMoves<C>(board, state, state.checkMask, moves);
+    GeneratePieceTypeMoves<C, Piece::Knight>(board, state, state.checkMask, moves);
+    GeneratePieceTypeMoves<C, Piece::Bishop>(board, state, state.checkMask, moves);
+    GeneratePieceTypeMoves<C, Piece::Rook>(board, state, state.checkMask, moves);
+    GeneratePieceTypeMoves<C, Piece::Queen>(board, state, state.checkMask, moves);
+    GenerateEnPassantMoves<C>(board, state, moves);
+}
+
+void Generator::UpdateCheckInfo(const std::shared_ptr<Board> &board, const AttackInfo &info, CheckInfo &checkInfo) const {
+    if(board->GetColorToMove() == Color::White) {
+        UpdateCheckInfo<Color::White>(board, info, checkInfo);
+    } else {
+        UpdateCheckInfo<Color::Black>(board, info, checkInfo);
     }
+}
 
-    // Rooks
-    U64 rooks = board->GetBoard(fColor, Piece::Rook);
-    while(rooks) {
-        const U8 lsb = __builtin_ctzll(rooks);
-        const U64 rook = 1ULL << lsb;
-        U64 attacks = (hypQuint(rook, fOccupancy, fPrimaryStraightAttacks[lsb]) | hypQuint(rook, fOccupancy, fSecondaryStraightAttacks[lsb])) & fEnemy;
-        while(attacks) {
-            U64 attack = 1ULL << __builtin_ctzll(attacks);
-            U16 move = 0;
-            SetMove(move, rook, attack);
-            fCaptureMoves.push_back(move);
-            attacks &= attacks - 1;
+bool Generator::GivesCheck(const std::shared_ptr<Board> &board, const CheckInfo &checkInfo, const U16 move) const {
+    const U8 from = move & ORIGIN_MASK;
+    const U8 to = (move & TARGET_MASK) >> 6;
+    const U64 origin = 1ULL << from;
+    const U64 target = 1ULL << to;
+    const U64 enemyKing = 1ULL << checkInfo.enemyKingLSB;
+
+    // Direct check, a promoting pawn is never on a pawn check square so promotions are left until below
+    if(checkInfo.checkSquares[(int)board->GetMovePiece(move)] & target)
+        return true;
+
+    // Discovered check, unless the piece stays on the line between our slider and the king
+    if((checkInfo.discoveryCandidates & origin) && !(ATTACK_TABLES.line[checkInfo.enemyKingLSB][from] & target))
+        return true;
+
+    if(GetMoveIsPromotion(move)) {
+        // The promoted piece sees through the square the pawn left
+        const U64 occupancy = board->GetOccupancy() ^ origin;
+        switch(GetMovePromotionPiece(move)) {
+            case Piece::Knight: return ATTACK_TABLES.knight[to] & enemyKing;
+            case Piece::Bishop: return GetBishopAttacks(to, occupancy) & enemyKing;
+            case Piece::Rook: return GetRookAttacks(to, occupancy) & enemyKing;
+            default: return GetQueenAttacks(to, occupancy) & enemyKing;
         }
-        rooks &= rooks - 1;
     }
 
-    // Bishops
-    U64 bishops = board->GetBoard(fColor, Piece::Bishop);
-    while(bishops) {
-        const U8 lsb = __builtin_ctzll(bishops);
-        const U64 bishop = 1ULL << lsb;
-        U64 attacks = (hypQuint(bishop, fOccupancy, fPrimaryDiagonalAttacks[lsb]) | hypQuint(bishop, fOccupancy, fSecondaryDiagonalAttacks[lsb])) & fEnemy;
-        while(attacks) {
-            U64 attack = 1ULL << __builtin_ctzll(attacks);
-            U16 move = 0;
-            SetMove(move, bishop, attack);
-            fCaptureMoves.push_back(move);
-            attacks &= attacks - 1;
-        }
-        bishops &= bishops - 1;
+    const Color us = board->GetColorToMove();
+    if(GetMoveIsEnPassant(move)) {
+        // The taken pawn leaving can open a line from one of our sliders too, test the resulting position directly
+        const U64 occupancy = (board->GetOccupancy() ^ origin ^ (get_rank(origin) & get_file(target))) | target;
+        const U64 queens = board->GetBoard(us, Piece::Queen);
+        return (GetRookAttacks(checkInfo.enemyKingLSB, occupancy) & (board->GetBoard(us, Piece::Rook) | queens)) ||
+            (GetBishopAttacks(checkInfo.enemyKingLSB, occupancy) & (board->GetBoard(us, Piece::Bishop) | queens));
     }
 
-    // Queens
-    U64 queens = board->GetBoard(fColor, Piece::Queen); // Could have multiple due to promotion
-    while(queens) {
-        const U8 lsb = __builtin_ctzll(queens);
-        const U64 queen = 1ULL << lsb;
-        U64 attacks = (hypQuint(queen, fOccupancy, fPrimaryStraightAttacks[lsb]) | hypQuint(queen, fOccupancy, fSecondaryStraightAttacks[lsb]) | hypQuint(queen, fOccupancy, fPrimaryDiagonalAttacks[lsb]) | hypQuint(queen, fOccupancy, fSecondaryDiagonalAttacks[lsb])) & fEnemy;
-        while(attacks) {
-            U64 attack = 1ULL << __builtin_ctzll(attacks);
-            U16 move = 0;
-            SetMove(move, queen, attack);
-            fCaptureMoves.push_back(move);
-            attacks &= attacks - 1;
-        }
-        queens &= queens - 1;
+    if(GetMoveIsCastling(move)) {
+        // Only the rook can give check, from the square it lands on beside the king
+        const bool white = us == Color::White;
+        const U64 rookFrom = GetMoveFlag(move) == MOVE_KING_CASTLE ? (white ? SQUARE_H1 : SQUARE_H8) : (white ? SQUARE_A1 : SQUARE_A8);
+        const U64 rookTo = GetMoveFlag(move) == MOVE_KING_CASTLE ? (white ? SQUARE_F1 : SQUARE_F8) : (white ? SQUARE_D1 : SQUARE_D8);
+        const U64 occupancy = (board->GetOccupancy() ^ origin ^ rookFrom) | target | rookTo;
+        return GetRookAttacks(__builtin_ctzll(rookTo), occupancy) & enemyKing;
     }
+    return false;
+}
 
-    // Pawns
-    U64 pawns = board->GetBoard(fColor, Piece::Pawn);
+template<Color C>
+void Generator::UpdateCheckInfo(const std::shared_ptr<Board> &board, const AttackInfo &state, CheckInfo &info) const {
+    constexpr Color them = opposite(C);
+    info.enemyKingLSB = __builtin_ctzll(board->GetBoard(them, Piece::King));
+    const U8 kingLSB = info.enemyKingLSB;
+
+    // A piece checks the king from exactly the squares the same piece on the king's square would attack
+    info.checkSquares[(int)Piece::Null] = 0;
+    info.checkSquares[(int)Piece::Pawn] = ATTACK_TABLES.pawn[(int)them][kingLSB];
+    info.checkSquares[(int)Piece::Knight] = ATTACK_TABLES.knight[kingLSB];
+    info.checkSquares[(int)Piece::Bishop] = GetBishopAttacks(kingLSB, state.occupancy);
+    info.checkSquares[(int)Piece::Rook] = GetRookAttacks(kingLSB, state.occupancy);
+    info.checkSquares[(int)Piece::Queen] = info.checkSquares[(int)Piece::Bishop] | info.checkSquares[(int)Piece::Rook];
+    info.checkSquares[(int)Piece::King] = 0;
+
+    // Our sliders sharing a line with the enemy king check it once the only piece in the way, if it is ours, moves off
+    info.discoveryCandidates = 0;
+    const U64 friendly = board->GetBoard(C);
+    const U64 queens = board->GetBoard(C, Piece::Queen);
+    U64 snipers = (ATTACK_TABLES.bishop[kingLSB] & (board->GetBoard(C, Piece::Bishop) | queens)) |
+        (ATTACK_TABLES.rook[kingLSB] & (board->GetBoard(C, Piece::Rook) | queens));
+    while(snipers) {
+        const U64 blockers = ATTACK_TABLES.between[kingLSB][__builtin_ctzll(snipers)] & state.occupancy;
+        if(blockers && !(blockers & (blockers - 1)) && (blockers & friendly))
+            info.discoveryCandidates |= blockers;
+        snipers &= snipers - 1;
+    }
+}
+
+template<Color C>
+void Generator::GenerateQuietChecks(const std::shared_ptr<Board> &board, const AttackInfo &state, MoveList &moves) const {
+    constexpr U64 startRank = C == Color::White ? RANK_2 : RANK_7;
+    constexpr U64 promotionRank = C == Color::White ? RANK_8 : RANK_1;
+    CheckInfo info;
+    UpdateCheckInfo<C>(board, state, info);
+
+    // Pushes onto the last rank are promotions, left to the capture stage with the other promotions
+    U64 pawns = board->GetBoard(C, Piece::Pawn);
     while(pawns) {
         const U8 lsb = __builtin_ctzll(pawns);
         const U64 pawn = 1ULL << lsb;
-        U64 attacks = (fColor == Color::White ? (north_east(pawn) | north_west(pawn)) : (south_east(pawn) | south_west(pawn))) & fEnemy;
-        while(attacks) {
-            U64 attack = 1ULL << __builtin_ctzll(attacks);
-            U16 move = 0;
-            SetMove(move, pawn, attack);
-            fCaptureMoves.push_back(move);
-            attacks &= attacks - 1;
-        }
+        const U64 oneSquareForward = pawn_push<C>(pawn) & ~state.occupancy;
+        U64 doublePush = 0;
+        if(oneSquareForward && (pawn & startRank))
+            doublePush = pawn_push<C>(oneSquareForward) & ~state.occupancy;
+        const U64 allowed = GetPinRay(state, lsb) & GetCheckingTargets(info, info.checkSquares[(int)Piece::Pawn], lsb);
+        AddMoves(pawn, oneSquareForward & ~promotionRank & allowed, MOVE_QUIET, moves);
+        AddMoves(pawn, doublePush & allowed, MOVE_DOUBLE_PUSH, moves);
         pawns &= pawns - 1;
     }
-}
-
-void Generator::GenerateEnPassantCaptureMoves(const std::shared_ptr<Board> &board) {
-    // En-passant not possible so throw away early
-    if((!board->GetWasLoadedFromFEN() && board->GetNMoves() < MIN_MOVES_FOR_ENPASSANT) || 
-        (board->GetWasLoadedFromFEN() && !board->GetEnPassantFEN() && board->GetNMoves() < 1))
-        return;
-
-    // FEN loaded position with en-passant move immediately available
-    if(board->GetWasLoadedFromFEN() && board->GetEnPassantFEN() && board->GetNMoves() < 1) {
-        U64 attackSquares = 0;
-        U64 target = board->GetEnPassantFEN();
-        if(fColor == Color::White) {
-            attackSquares = (south_east(target) | south_west(target)) & board->GetBoard(Color::White, Piece::Pawn);
-        } else {
-            attackSquares = (north_east(target) | north_west(target)) & board->GetBoard(Color::Black, Piece::Pawn);
-        }
-
-        while(attackSquares) {
-            U64 pawn = 1ULL << __builtin_ctzll(attackSquares);
-            U16 move = 0;
-            SetMove(move, pawn, target);
-            fLegalMoves.push_back(move);
-            attackSquares &= attackSquares - 1;
-        }
-    }
 
-    // No en-passant possible if no previous moves (e.g. FEN loaded position)
-    if(board->GetNMoves() < 1) 
-        return;
-
-    // Can't be wrapped in an else bracket due to undoing moves
-    // Now run the usual code
-    U16 lastMove = board->GetLastMove();
-    U64 lastMoveTarget = GetMoveTarget(lastMove);
-    U64 lastMoveOrigin = GetMoveOrigin(lastMove);
-
-    // Faster return if you know en-passant will not be possible
-    if(board->GetLastPieceMoved() != Piece::Pawn || GetMoveIsCastling(lastMove))
-        return;
-
-    U64 enPassantPawns = 0;
-    U64 attackingPawns = board->GetBoard(fColor, Piece::Pawn);
-    if(((get_rank(lastMoveTarget) & RANK_5) && (fOtherColor == Color::Black) && (get_rank(lastMoveOrigin) & RANK_7))
-    || ((get_rank(lastMoveTarget) & RANK_4) && (fOtherColor == Color::White) && (get_rank(lastMoveOrigin) & RANK_2))) {
-        enPassantPawns = (east(lastMoveTarget) | west(lastMoveTarget)) & attackingPawns;
-    }
+    GeneratePieceTypeQuietChecks<C, Piece::Knight>(board, state, info, moves);
+    GeneratePieceTypeQuietChecks<C, Piece::Bishop>(board, state, info, moves);
+    GeneratePieceTypeQuietChecks<C, Piece::Rook>(board, state, info, moves);
+    GeneratePieceTypeQuietChecks<C, Piece::Queen>(board, state, info, moves);
 
-    while(enPassantPawns) {
-        const U64 pawn = 1ULL << __builtin_ctzll(enPassantPawns);
-        U16 move = 0;
-        SetMove(move, pawn, fColor == Color::White ? north(lastMoveTarget) : south(lastMoveTarget));
-        fLegalMoves.push_back(move);
-        enPassantPawns &= enPassantPawns - 1;
-    }
+    // The king never checks directly, it can only discover check
+    const U8 kingLSB = __builtin_ctzll(state.king);
+    if(info.discoveryCandidates & state.king)
+        GenerateKingMoves(state, ~state.occupancy & ~ATTACK_TABLES.line[info.enemyKingLSB][kingLSB], moves);
 }
 
-void Generator::RemoveIllegalCaptureMoves(const std::shared_ptr<Board> &board) {
-    // Check all the illegal moves, e.g. do they result in your own king being in check?
-    // Check all the illegal moves, e.g. do they result in your own king being in check?
-    const U64 underAttack = GetAttacks(board, fOtherColor);
-
-    if(fKing & underAttack) // Player to move is in check, only moves resolving the check can be permitted
-        PruneCheckMoves(board, true);
-    fPinnedPieces.clear(); // Empty the vector from the last call
-    for(Direction d : DIRECTIONS) {
-        AddAbolsutePins(board, d);
-    }
-    fPinnedPositions = std::accumulate(
-        fPinnedPieces.begin(), fPinnedPieces.end(), U64(0),
-        [](U64 acc, const std::pair<U64, U64>& p) {
-            return acc | p.first;
-        }
-    );
-
-    for(int iMove = 0; iMove < (int)fCaptureMoves.size(); iMove++) {
-        const U16 m = fCaptureMoves[iMove];
-        const U64 moveOrigin = GetMoveOrigin(m);
-        const U64 moveTarget = GetMoveTarget(m);
-        // King cant move to squares the opponent attacks
-        if((board->GetMovePiece(m) == Piece::King) && (moveTarget & underAttack)) {
-            fCaptureMoves.erase(std::begin(fCaptureMoves) + iMove);
-            iMove--;
-        } else if(fPinnedPositions & moveOrigin) { // Piece originates from a pinned position
-            // Absolutely pinned pieces may not move, unless it is a capture of that piece or along pinning ray
-            for(const std::pair<U64, U64> &pins : fPinnedPieces) {
-                // !Piece moving from pinned position to somewhere on the associated pinning ray (incl capture)
-                if((moveOrigin & pins.first) && (moveTarget & ~pins.second)) {
-                    // Moving to somewhere off the absolutely pinning ray (illegal)
-                    fCaptureMoves.erase(std::begin(fCaptureMoves) + iMove);
-                    iMove--;
-                }
-            }
-        } else if(board->GetMoveIsEnPassant(m, board->GetMovePiece(m), board->GetIsOccupied(moveTarget).second == Piece::Null)) { // Need to be manually checked due to rook rays
-            U64 activeRank = get_rank(moveOrigin);
-            U64 kingOnRank = fKing & activeRank; // King shares the rank with the en-passanting pawn
-            U64 rookOnRank = activeRank & (board->GetBoard(fOtherColor, Piece::Rook) | board->GetBoard(fOtherColor, Piece::Queen)); // Rook or queen have sliding straight attacks
-
-            if(kingOnRank && rookOnRank) { // King, two pawns and rook/queen(s) occupy the same rank
-                // Is en-passant so the captured pawn occupies the same rank as well, if we remove our pawn and the
-                // captured pawn does this leave our king on a rank with just itself and the attacking rook/queen
-
-                // MSB is the left-most bit (i.e. that with lowest index)
-                const U8 kingMSB = __builtin_clzll(fKing);
-                const U8 rookMSB = __builtin_clzll(rookOnRank);
-
-                int attackingRookBit = kingMSB < rookMSB ? 63 - rookMSB : __builtin_ctzll(rookOnRank);
-                U64 rook = 1ULL << attackingRookBit; // Again could be a queen but it doesn't matter, this is the one checking king if move happens
-                U64 rookShift = kingMSB < rookMSB ? east(rook) : west(rook);
-                U64 takenPawn = fColor == Color::White ? south(moveTarget) : north(moveTarget);
-
-                // Make a custom occupancy mask to cut the rook ray down
-                U64 mask = fKing | rook | rookShift;
-                U64 rookRay = hypQuint(rook, mask, fPrimaryStraightAttacks[attackingRookBit]);
-
-                // Subtract from the ray our pawns that we know intersect the ray
-                rookRay ^= (moveOrigin | takenPawn | fKing | rookShift);
-
-                if(!(rookRay & fOccupancy)) { // No pieces on the ray so if en-passant happens king will be in check
-                    fCaptureMoves.erase(std::begin(fCaptureMoves) + iMove);
-                    iMove--;
-                }
-            }
-        }
+template<Color C, Piece P>
+void Generator::GeneratePieceTypeQuietChecks(const std::shared_ptr<Board> &board, const AttackInfo &state, const CheckInfo &info, MoveList &moves) const {
+    U64 pieces = board->GetBoard(C, P);
+    if constexpr(P == Piece::Knight)
+        pieces &= ~state.pinned; // A pinned knight can never stay on its pinning ray
+    while(pieces) {
+        const U8 lsb = __builtin_ctzll(pieces);
+        U64 allowed = ~state.occupancy & GetCheckingTargets(info, info.checkSquares[(int)P], lsb);
+        if constexpr(P != Piece::Knight)
+            allowed &= GetPinRay(state, lsb);
+        AddMoves(1ULL << lsb, GetPieceAttacks<P>(lsb, state.occupancy) & allowed, MOVE_QUIET, moves);
+        pieces &= pieces - 1;
     }
 }
 
-void Generator::GeneratePseudoLegalMoves(const std::shared_ptr<Board> &board) {
-    GeneratePawnPseudoLegalMoves(board);
-    GenerateKingPseudoLegalMoves();
-    GenerateKnightPseudoLegalMoves(board);
-    GenerateBishopPseudoLegalMoves(board);
-    GenerateRookPseudoLegalMoves(board);
-    GenerateQueenPseudoLegalMoves(board);
-
-    // Erase all moves moving onto a square of its own colour
-    const U64 selfOccupancy = board->GetBoard(fColor);
-    fLegalMoves.erase(std::remove_if(fLegalMoves.begin(), fLegalMoves.end(), [&](U16 move) {
-        return GetMoveTarget(move) & selfOccupancy;
-    }), fLegalMoves.end());
+template<Color C>
+void Generator::GeneratePieceMoves(const std::shared_ptr<Board> &board, const AttackInfo &state, const U64 targets, MoveList &moves) const {
+    const U64 pieceTargets = targets & state.checkMask;
+    if(pieceTargets)
+        GeneratePawnMoves<C>(board, state, pieceTargets, moves);
+    GenerateKingMoves(state, targets, moves);
+    if(!pieceTargets) // Double check, or no target square resolves the check
+        return;
+    GeneratePieceTypeMoves<C, Piece::Knight>(board, state, pieceTargets, moves);
+    GeneratePieceTypeMoves<C, Piece::Bishop>(board, state, pieceTargets, moves);
+    GeneratePieceTypeMoves<C, Piece::Rook>(board, state, pieceTargets, moves);
+    GeneratePieceTypeMoves<C, Piece::Queen>(board, state, pieceTargets, moves); // Could have multiple due to promotion
 }
 
-void Generator::GenerateKingPseudoLegalMoves() {
-    U64 attacks = fKingAttacks[__builtin_ctzll(fKing)];
-    while(attacks) {
-        const U64 attack = 1ULL << __builtin_ctzll(attacks);
+void Generator::AddMoves(const U64 origin, U64 targets, const U16 flag, MoveList &moves) {
+    while(targets) {
+        const U64 target = 1ULL << __builtin_ctzll(targets);
         U16 move = 0;
-        SetMove(move, fKing, attack);
-        fLegalMoves.push_back(move);
-        attacks &= attacks - 1; // Clear the lowest set bit
+        SetMove(move, origin, target, flag);
+        moves.Add(move);
+        targets &= targets - 1; // Clear the lowest set bit
     }
 }
 
-void Generator::GenerateKnightPseudoLegalMoves(const std::shared_ptr<Board> &board) {
-    U64 knights = board->GetBoard(fColor, Piece::Knight);
-    while(knights) {
-        const U8 lsb = __builtin_ctzll(knights);
-        const U64 knight = 1ULL << lsb;
-        U64 attacks = fKnightAttacks[lsb];
-        while(attacks) {
-            const U64 attack = 1ULL << __builtin_ctzll(attacks);
-            U16 move = 0;
-            SetMove(move, knight, attack);
-            fLegalMoves.push_back(move);
-            attacks &= attacks - 1; // Clear the lowest set bit
+template<Color C>
+void Generator::AddPawnMoves(const U64 pawn, U64 targets, const U16 flag, MoveList &moves) {
+    constexpr U64 promotionRank = C == Color::White ? RANK_8 : RANK_1;
+    while(targets) {
+        const U64 target = 1ULL << __builtin_ctzll(targets);
+        U16 move = 0;
+        SetMove(move, pawn, target, flag);
+        if(target & promotionRank) {
+            for(Piece p : PROMOTION_PIECES) {
+                SetMovePromotionPiece(move, p);
+                moves.Add(move);
+            }
+        } else {
+            moves.Add(move);
         }
-        knights &= knights - 1;
+        targets &= targets - 1;
     }
 }
 
-void Generator::GenerateRookPseudoLegalMoves(const std::shared_ptr<Board> &board) {
-    U64 rooks = board->GetBoard(fColor, Piece::Rook);
-    while(rooks) {
-        const U8 lsb = __builtin_ctzll(rooks);
-        const U64 rook = 1ULL << lsb;
-        U64 attacks = (hypQuint(rook, fOccupancy, fPrimaryStraightAttacks[lsb]) | hypQuint(rook, fOccupancy, fSecondaryStraightAttacks[lsb]));
-        while(attacks) {
-            U64 attack = 1ULL << __builtin_ctzll(attacks);
-            U16 move = 0;
-            SetMove(move, rook, attack);
-            fLegalMoves.push_back(move);
-            attacks &= attacks - 1;
-        }
-        rooks &= rooks - 1;
-    }
+void Generator::GenerateKingMoves(const AttackInfo &state, const U64 targets, MoveList &moves) const {
+    const U64 kingMoves = ATTACK_TABLES.king[__builtin_ctzll(state.king)] & targets & ~state.enemyAttacks;
+    AddMoves(state.king, kingMoves & state.enemy, MOVE_CAPTURE, moves);
+    AddMoves(state.king, kingMoves & ~state.enemy, MOVE_QUIET, moves);
 }
 
-void Generator::GenerateBishopPseudoLegalMoves(const std::shared_ptr<Board> &board) {
-    U64 bishops = board->GetBoard(fColor, Piece::Bishop);
-    while(bishops) {
-        const U8 lsb = __builtin_ctzll(bishops);
-        const U64 bishop = 1ULL << lsb;
-        U64 attacks = (hypQuint(bishop, fOccupancy, fPrimaryDiagonalAttacks[lsb]) | hypQuint(bishop, fOccupancy, fSecondaryDiagonalAttacks[lsb]));
-        while(attacks) {
-            U64 attack = 1ULL << __builtin_ctzll(attacks);
-            U16 move = 0;
-            SetMove(move, bishop, attack);
-            fLegalMoves.push_back(move);
-            attacks &= attacks - 1;
-        }
-        bishops &= bishops - 1;
+template<Color C, Piece P>
+void Generator::GeneratePieceTypeMoves(const std::shared_ptr<Board> &board, const AttackInfo &state, const U64 targets, MoveList &moves) const {
+    U64 pieces = board->GetBoard(C, P);
+    if constexpr(P == Piece::Knight)
+        pieces &= ~state.pinned; // A pinned knight can never stay on its pinning ray
+    while(pieces) {
+        const U8 lsb = __builtin_ctzll(pieces);
+        U64 allowed = targets;
+        if constexpr(P != Piece::Knight)
+            allowed &= GetPinRay(state, lsb);
+        const U64 pieceMoves = GetPieceAttacks<P>(lsb, state.occupancy) & allowed;
+        AddMoves(1ULL << lsb, pieceMoves & state.enemy, MOVE_CAPTURE, moves);
+        AddMoves(1ULL << lsb, pieceMoves & ~state.enemy, MOVE_QUIET, moves);
+        pieces &= pieces - 1;
     }
 }
 
-void Generator::GenerateQueenPseudoLegalMoves(const std::shared_ptr<Board> &board) {
-    U64 queens = board->GetBoard(fColor, Piece::Queen); // Could have multiple due to promotion
-    while(queens) {
-        const U8 lsb = __builtin_ctzll(queens);
-        const U64 queen = 1ULL << lsb;
-        U64 attacks = (hypQuint(queen, fOccupancy, fPrimaryStraightAttacks[lsb]) | hypQuint(queen, fOccupancy, fSecondaryStraightAttacks[lsb]) | hypQuint(queen, fOccupancy, fPrimaryDiagonalAttacks[lsb]) | hypQuint(queen, fOccupancy, fSecondaryDiagonalAttacks[lsb]));
-        while(attacks) {
-            U64 attack = 1ULL << __builtin_ctzll(attacks);
-            U16 move = 0;
-            SetMove(move, queen, attack);
-            fLegalMoves.push_back(move);
-            attacks &= attacks - 1;
-        }
-        queens &= queens - 1;
-    }
-}
-
-void Generator::GeneratePawnPseudoLegalMoves(const std::shared_ptr<Board> &board) {
-    U64 pawns = board->GetBoard(fColor, Piece::Pawn);
-    const U64 enemy = board->GetBoard(fOtherColor);
-    const U64 promotionRank = fColor == Color::White ? RANK_8 : RANK_1;
-    const U64 startRank = fColor == Color::White ? RANK_2 : RANK_7;
+template<Color C>
+void Generator::GeneratePawnMoves(const std::shared_ptr<Board> &board, const AttackInfo &state, const U64 targets, MoveList &moves) const {
+    constexpr U64 startRank = C == Color::White ? RANK_2 : RANK_7;
+    U64 pawns = board->GetBoard(C, Piece::Pawn);
     while(pawns) {
         const U8 lsb = __builtin_ctzll(pawns);
-        U64 pawn = 1ULL << lsb;
+        const U64 pawn = 1ULL << lsb;
+        const U64 allowed = targets & GetPinRay(state, lsb);
 
         // Only allow diagonal attacks if occupied by enemy piece
-        U64 attacks = (fColor == Color::White ? fWhitePawnDiagonalAttacks[lsb] : fBlackPawnDiagonalAttacks[lsb]) & enemy;
-
-        while(attacks) {
-            const U64 attack = 1ULL << __builtin_ctzll(attacks);
-            U16 move = 0;
-            SetMove(move, pawn, attack);
-            if(attack & promotionRank) {
-                for(Piece p : PROMOTION_PIECES) {
-                    SetMovePromotionPiece(move, p);
-                    fLegalMoves.push_back(move);
-                }
-            } else {
-                fLegalMoves.push_back(move);
-            }
-            attacks &= attacks - 1;
-        }
-        attacks = 0;
+        const U64 attacks = ATTACK_TABLES.pawn[(int)C][lsb] & state.enemy;
+        AddPawnMoves<C>(pawn, attacks & allowed, MOVE_CAPTURE, moves);
 
         // Get rid of 2-square attack if 1st or 2nd square is occupied, add single square attacks
-        U64 oneSquareForward = (fColor == Color::White ? north(pawn) : south(pawn)) & ~fOccupancy;
-        attacks |= oneSquareForward;
+        const U64 oneSquareForward = pawn_push<C>(pawn) & ~state.occupancy;
+        AddPawnMoves<C>(pawn, oneSquareForward & allowed, MOVE_QUIET, moves); // Forward moves don't take pieces
         if(oneSquareForward && (pawn & startRank))
-            attacks |= (fColor == Color::White ? north(north(pawn)) : south(south(pawn))) & ~fOccupancy;
-
-        while(attacks) {
-            const U64 attack = 1ULL << __builtin_ctzll(attacks);
-            U16 move = 0;
-            SetMove(move, pawn, attack); // Forward moves don't take pieces
-            if(attack & promotionRank) {
-                for(Piece p : PROMOTION_PIECES) {
-                    SetMovePromotionPiece(move, p);
-                    fLegalMoves.push_back(move);
-                }
-            } else {
-                fLegalMoves.push_back(move);
-            }
-            attacks &= attacks - 1;
-        }
+            AddMoves(pawn, pawn_push<C>(oneSquareForward) & ~state.occupancy & allowed, MOVE_DOUBLE_PUSH, moves);
         pawns &= pawns - 1; // Drop the least significant bit
     }
 }
 
-void Generator::GenerateCastlingMoves(const std::shared_ptr<Board> &board) {
-    // Return quickly if we know castling is not possible
-    if(board->GetNMoves() < MIN_MOVES_FOR_CASTLING && !board->GetWasLoadedFromFEN())
+template<Color C>
+void Generator::GenerateCastlingMoves(const std::shared_ptr<Board> &board, const AttackInfo &state, MoveList &moves) const {
+    // Return quickly if we know castling is not possible, can't castle out of check either
+    if((board->GetNMoves() < MIN_MOVES_FOR_CASTLING && !board->GetWasLoadedFromFEN()) || state.checkers)
         return;
 
-    U16 move = 0;
-    if(fColor == Color::White && !board->GetWhiteKingMoved()) {
-        if(!board->GetWhiteKingsideRookMoved() && 
-            IsCastlingPossible(KING_SIDE_CASTLING_MASK_WHITE, KING_SIDE_CASTLING_OCCUPANCY_MASK_WHITE, board)) 
-        {
-            SetMove(move, fKing, SQUARE_G1);
-            SetMoveIsCastling(move, true);
-            fLegalMoves.push_back(move);
-            move = 0;
-        }
-        if(!board->GetWhiteQueensideRookMoved() &&
-            IsCastlingPossible(QUEEN_SIDE_CASTLING_MASK_WHITE, QUEEN_SIDE_CASTLING_OCCUPANCY_MASK_WHITE, board)) {
-            SetMove(move, fKing, SQUARE_C1);
-            SetMoveIsCastling(move, true);
-            fLegalMoves.push_back(move);
-            move = 0;
-        }
-    } else if(fColor == Color::Black && !board->GetBlackKingMoved()) {
-        if(!board->GetBlackKingsideRookMoved() &&
-            IsCastlingPossible(KING_SIDE_CASTLING_MASK_BLACK, KING_SIDE_CASTLING_OCCUPANCY_MASK_BLACK, board)) 
-        {
-            SetMove(move, fKing, SQUARE_G8);
-            SetMoveIsCastling(move, true);
-            fLegalMoves.push_back(move);
-            move = 0;
-        }
-        if (!board->GetBlackQueensideRookMoved() &&
-            IsCastlingPossible(QUEEN_SIDE_CASTLING_MASK_BLACK, QUEEN_SIDE_CASTLING_OCCUPANCY_MASK_BLACK, board)) 
-        {
-            SetMove(move, fKing, SQUARE_C8);
-            SetMoveIsCastling(move, true);
-            fLegalMoves.push_back(move);
-            move = 0;
-        }
+    constexpr bool white = C == Color::White;
+    constexpr U8 kingSideRight = white ? CASTLING_WHITE_KINGSIDE : CASTLING_BLACK_KINGSIDE;
+    constexpr U8 queenSideRight = white ? CASTLING_WHITE_QUEENSIDE : CASTLING_BLACK_QUEENSIDE;
+    const U8 rights = board->GetCastlingRights();
+    if((rights & kingSideRight) &&
+        IsCastlingPossible(state, white ? KING_SIDE_CASTLING_MASK_WHITE : KING_SIDE_CASTLING_MASK_BLACK,
+            white ? KING_SIDE_CASTLING_OCCUPANCY_MASK_WHITE : KING_SIDE_CASTLING_OCCUPANCY_MASK_BLACK))
+    {
+        U16 move = 0;
+        SetMove(move, state.king, white ? SQUARE_G1 : SQUARE_G8, MOVE_KING_CASTLE);
+        moves.Add(move);
+    }
+    if((rights & queenSideRight) &&
+        IsCastlingPossible(state, white ? QUEEN_SIDE_CASTLING_MASK_WHITE : QUEEN_SIDE_CASTLING_MASK_BLACK,
+            white ? QUEEN_SIDE_CASTLING_OCCUPANCY_MASK_WHITE : QUEEN_SIDE_CASTLING_OCCUPANCY_MASK_BLACK))
+    {
+        U16 move = 0;
+        SetMove(move, state.king, white ? SQUARE_C1 : SQUARE_C8, MOVE_QUEEN_CASTLE);
+        moves.Add(move);
     }
 }
 
-bool Generator::IsCastlingPossible(U64 castlingMask, U64 occupancyMask, const std::shared_ptr<Board> &board) {
-    return !(fOccupancy & occupancyMask) && !IsUnderAttack(castlingMask, fOtherColor, board);
+bool Generator::IsCastlingPossible(const AttackInfo &state, U64 castlingMask, U64 occupancyMask) {
+    return !(state.occupancy & occupancyMask) && !(castlingMask & state.enemyAttacks);
 }
 
-bool Generator::IsUnderAttack(const U64 mask, const Color attackingColor, const std::shared_ptr<Board> &board) {    
+bool Generator::IsUnderAttack(const U64 mask, const Color attackingColor, const std::shared_ptr<Board> &board) const {    
     const U64 attacker = board->GetBoard(attackingColor);
     const U64 attacks = GetAttacks(board, attackingColor);
     return attacks & mask & ~attacker;
 }
 
-U64 Generator::GetAttacks(const std::shared_ptr<Board> &board, const Color attackingColor) {
+U64 Generator::GetAttacks(const std::shared_ptr<Board> &board, const Color attackingColor) const {
+    if(attackingColor == Color::White)
+        return GetAttacks<Color::White>(board, board->GetOccupancy());
+    return GetAttacks<Color::Black>(board, board->GetOccupancy());
+}
+
+template<Color C>
+U64 Generator::GetAttacks(const std::shared_ptr<Board> &board, const U64 occupancy) const {
     U64 attacks = 0;
-    const U64 occ = board->GetOccupancy(); // Cannot replace with fOccupancy?????
 
     // Pawns (only diagonal forwards check as only care about attacks)
-    const U64 pawns = board->GetBoard(attackingColor, Piece::Pawn);
-    if(attackingColor == Color::White) {
-        attacks |= (north_east(pawns) | north_west(pawns));
-    } else {
-        attacks |= (south_east(pawns) | south_west(pawns));   
-    }
+    attacks |= pawn_attacks<C>(board->GetBoard(C, Piece::Pawn));
 
     // Knight attacks
-    U64 knights = board->GetBoard(attackingColor, Piece::Knight);
+    U64 knights = board->GetBoard(C, Piece::Knight);
     while(knights) {
-        attacks |= fKnightAttacks[__builtin_ctzll(knights)];
+        attacks |= ATTACK_TABLES.knight[__builtin_ctzll(knights)];
         knights &= knights - 1;
     }
 
     // King
-    U64 king = board->GetBoard(attackingColor, Piece::King);
-    attacks |= fKingAttacks[__builtin_ctzll(king)];
+    U64 king = board->GetBoard(C, Piece::King);
+    attacks |= ATTACK_TABLES.king[__builtin_ctzll(king)];
 
     // Bishops
-    U64 bishops = board->GetBoard(attackingColor, Piece::Bishop);
+    U64 bishops = board->GetBoard(C, Piece::Bishop);
     while(bishops) {
         const U8 lsb = __builtin_ctzll(bishops);
-        const U64 bishop = 1ULL << lsb;
-        attacks |= (hypQuint(bishop, occ, fPrimaryDiagonalAttacks[lsb]) | hypQuint(bishop, occ, fSecondaryDiagonalAttacks[lsb]));
+        attacks |= GetBishopAttacks(lsb, occupancy);
         bishops &= bishops - 1;
     }
 
     // Rooks
-    U64 rooks = board->GetBoard(attackingColor, Piece::Rook);
+    U64 rooks = board->GetBoard(C, Piece::Rook);
     while(rooks) {
         const U8 lsb = __builtin_ctzll(rooks);
-        const U64 rook = 1ULL << lsb;
-        attacks |= (hypQuint(rook, occ, fPrimaryStraightAttacks[lsb]) | hypQuint(rook, occ, fSecondaryStraightAttacks[lsb]));
+        attacks |= GetRookAttacks(lsb, occupancy);
         rooks &= rooks - 1;
     }
 
     // Queens
-    U64 queens = board->GetBoard(attackingColor, Piece::Queen);
+    U64 queens = board->GetBoard(C, Piece::Queen);
     while(queens) {
         const U8 lsb = __builtin_ctzll(queens);
-        const U64 queen = 1ULL << lsb;
-        attacks |= (hypQuint(queen, occ, fPrimaryStraightAttacks[lsb]) | hypQuint(queen, occ, fSecondaryStraightAttacks[lsb]) | hypQuint(queen, occ, fPrimaryDiagonalAttacks[lsb]) | hypQuint(queen, occ, fSecondaryDiagonalAttacks[lsb]));
+        attacks |= GetQueenAttacks(lsb, occupancy);
         queens &= queens - 1;
     }
 
     return attacks; // Don't exclude your own pieces since they are protected so king cannot take them
 }
 
-void Generator::GenerateEnPassantMoves(const std::shared_ptr<Board> &board) {
-    // En-passant not possible so throw away early
-    if((!board->GetWasLoadedFromFEN() && board->GetNMoves() < MIN_MOVES_FOR_ENPASSANT) || 
-        (board->GetWasLoadedFromFEN() && !board->GetEnPassantFEN() && board->GetNMoves() < 1))
+template<Color C>
+void Generator::GenerateEnPassantMoves(const std::shared_ptr<Board> &board, const AttackInfo &state, MoveList &moves) const {
+    // En-passant not possible unless the last move was a double pawn push
+    const U64 target = board->GetEnPassantSquare();
+    if(!target)
         return;
 
-    // FEN loaded position with en-passant move immediately available
-    if(board->GetWasLoadedFromFEN() && board->GetEnPassantFEN() && board->GetNMoves() < 1) {
-        U64 attackSquares = 0;
-        U64 target = board->GetEnPassantFEN();
-        if(fColor == Color::White) {
-            attackSquares = (south_east(target) | south_west(target)) & board->GetBoard(Color::White, Piece::Pawn);
-        } else {
-            attackSquares = (north_east(target) | north_west(target)) & board->GetBoard(Color::Black, Piece::Pawn);
-        }
-
-        while(attackSquares) {
-            U64 pawn = 1ULL << __builtin_ctzll(attackSquares);
-            U16 move = 0;
-            SetMove(move, pawn, target);
-            fLegalMoves.push_back(move);
-            attackSquares &= attackSquares - 1;
-        }
-    }
-
-    // No en-passant possible if no previous moves (e.g. FEN loaded position)
-    if(board->GetNMoves() < 1) 
-        return;
-
-    // Can't be wrapped in an else bracket due to undoing moves
-    // Now run the usual code
-    U16 lastMove = board->GetLastMove();
-    U64 lastMoveTarget = GetMoveTarget(lastMove);
-    U64 lastMoveOrigin = GetMoveOrigin(lastMove);
-
-    // Faster return if you know en-passant will not be possible
-    if(board->GetLastPieceMoved() != Piece::Pawn || GetMoveIsCastling(lastMove))
+    // When in check the capture must take the checking pawn or land on the blocking square
+    const U64 takenPawn = pawn_push<opposite(C)>(target);
+    if(!((target | takenPawn) & state.checkMask))
         return;
 
-    U64 enPassantPawns = 0;
-    U64 attackingPawns = board->GetBoard(fColor, Piece::Pawn);
-    if(((get_rank(lastMoveTarget) & RANK_5) && (fOtherColor == Color::Black) && (get_rank(lastMoveOrigin) & RANK_7))
-    || ((get_rank(lastMoveTarget) & RANK_4) && (fOtherColor == Color::White) && (get_rank(lastMoveOrigin) & RANK_2))) {
-        enPassantPawns = (east(lastMoveTarget) | west(lastMoveTarget)) & attackingPawns;
-    }
-
-    while(enPassantPawns) {
-        const U64 pawn = 1ULL << __builtin_ctzll(enPassantPawns);
-        U16 move = 0;
-        SetMove(move, pawn, fColor == Color::White ? north(lastMoveTarget) : south(lastMoveTarget));
-        fLegalMoves.push_back(move);
-        enPassantPawns &= enPassantPawns - 1;
-    }
-}
-
-void Generator::RemoveIllegalMoves(const std::shared_ptr<Board> &board) {
-    // TODO: Rewrite this from the ground up to make it faster and more readable...
-
-    // Check all the illegal moves, e.g. do they result in your own king being in check?
-    const U64 underAttack = GetAttacks(board, fOtherColor);
-    if(fKing & underAttack) // Player to move is in check, only moves resolving the check can be permitted
-        PruneCheckMoves(board, false);
+    // Our pawns that could capture onto the target are those a pawn of the other colour there would attack
+    U64 attackSquares = pawn_attacks<opposite(C)>(target) & board->GetBoard(C, Piece::Pawn);
 
-    fPinnedPieces.clear(); // Empty the vector from the last call
-    for(Direction d : DIRECTIONS) {
-        AddAbolsutePins(board, d);
-    }
-
-    fPinnedPositions = std::accumulate(
-        fPinnedPieces.begin(), fPinnedPieces.end(), U64(0),
-        [](U64 acc, const std::pair<U64, U64>& p) {
-            return acc | p.first;
-        }
-    );
-
-    for(int iMove = 0; iMove < (int)fLegalMoves.size(); iMove++) {
-        const U16 m = fLegalMoves[iMove];
-        const U64 moveOrigin = GetMoveOrigin(m);
-        const U64 moveTarget = GetMoveTarget(m);
-        // King cant move to squares the opponent attacks
-        if((board->GetMovePiece(m) == Piece::King) && (moveTarget & underAttack)) {
-            fLegalMoves.erase(std::begin(fLegalMoves) + iMove);
-            iMove--;
-        } else if(fPinnedPositions & moveOrigin) { // Piece originates from a pinned position
-            // Absolutely pinned pieces may not move, unless it is a capture of that piece or along pinning ray
-            for(const std::pair<U64, U64> &pins : fPinnedPieces) {
-                // !Piece moving from pinned position to somewhere on the associated pinning ray (incl capture)
-                if((moveOrigin & pins.first) && (moveTarget & ~pins.second)) {
-                    // Moving to somewhere off the absolutely pinning ray (illegal)
-                    fLegalMoves.erase(std::begin(fLegalMoves) + iMove);
-                    iMove--;
-                }
-            }
-        } else if(board->GetMoveIsEnPassant(m, board->GetMovePiece(m), board->GetIsOccupied(moveTarget).second == Piece::Null)) { // Need to be manually checked due to rook rays
-            U64 activeRank = get_rank(moveOrigin);
-            U64 kingOnRank = fKing & activeRank; // King shares the rank with the en-passanting pawn
-            U64 rookOnRank = activeRank & (board->GetBoard(fOtherColor, Piece::Rook) | board->GetBoard(fOtherColor, Piece::Queen)); // Rook or queen have sliding straight attacks
-
-            if(kingOnRank && rookOnRank) { // King, two pawns and rook/queen(s) occupy the same rank
-                // Is en-passant so the captured pawn occupies the same rank as well, if we remove our pawn and the
-                // captured pawn does this leave our king on a rank with just itself and the attacking rook/queen
-
-                // MSB is the left-most bit (i.e. that with lowest index)
-                const U8 kingMSB = __builtin_clzll(fKing);
-                const U8 rookMSB = __builtin_clzll(rookOnRank);
-
-                int attackingRookBit = kingMSB < rookMSB ? 63 - rookMSB : __builtin_ctzll(rookOnRank);
-                U64 rook = 1ULL << attackingRookBit; // Again could be a queen but it doesn't matter, this is the one checking king if move happens
-                U64 rookShift = kingMSB < rookMSB ? east(rook) : west(rook);
-                U64 takenPawn = fColor == Color::White ? south(moveTarget) : north(moveTarget);
-
-                // Make a custom occupancy mask to cut the rook ray down
-                U64 mask = fKing | rook | rookShift;
-                U64 rookRay = hypQuint(rook, mask, fPrimaryStraightAttacks[attackingRookBit]);
-
-                // Subtract from the ray our pawns that we know intersect the ray
-                rookRay ^= (moveOrigin | takenPawn | fKing | rookShift);
-
-                if(!(rookRay & fOccupancy)) { // No pieces on the ray so if en-passant happens king will be in check
-                    fLegalMoves.erase(std::begin(fLegalMoves) + iMove);
-                    iMove--;
-                }
-            }
+    while(attackSquares) {
+        const U64 pawn = 1ULL << __builtin_ctzll(attackSquares);
+        if(GetEnPassantIsLegal<C>(board, state, pawn, target)) {
+            U16 move = 0;
+            SetMove(move, pawn, target, MOVE_EN_PASSANT);
+            moves.Add(move);
         }
+        attackSquares &= attackSquares - 1;
     }
 }
 
-void Generator::AddAbolsutePins(const std::shared_ptr<Board> &board, Direction d) {
-    // Make artificial occupancy to block in the king and only get the north ray
-    const U8 lsb = __builtin_ctzll(fKing);
-    U64 rayOccupancy = board->GetBoard(fOtherColor);
-    const U64 defendingRook = board->GetBoard(fOtherColor, Piece::Rook);
-    const U64 defendingBishop = board->GetBoard(fOtherColor, Piece::Bishop);
-    const U64 ownPieces = board->GetBoard(fColor);
-    U64 rayMask = 0;
-    U64 enemies = board->GetBoard(fOtherColor, Piece::Queen); // Queen can pin both ways so is always an "enemy"
-    U64 kingShift = 0;
-
-    switch(d) {
-        case Direction::North:
-            kingShift |= south(fKing);
-            rayMask = fSecondaryStraightAttacks[lsb];
-            enemies |= defendingRook;
-            break;
-        case Direction::East:
-            kingShift |= west(fKing);
-            rayMask = fPrimaryStraightAttacks[lsb];
-            enemies |= defendingRook;
-            break;
-        case Direction::West:
-            kingShift |= east(fKing);
-            rayMask = fPrimaryStraightAttacks[lsb];
-            enemies |= defendingRook;
-            break;
-        case Direction::South:
-            kingShift |= north(fKing);
-            rayMask = fSecondaryStraightAttacks[lsb];
-            enemies |= defendingRook;
-            break;
-        case Direction::NorthEast:
-            kingShift |= south_west(fKing);
-            rayMask = fSecondaryDiagonalAttacks[lsb];
-            enemies |= defendingBishop;
-            break;
-        case Direction::NorthWest:
-            kingShift |= south_east(fKing);
-            rayMask = fPrimaryDiagonalAttacks[lsb];
-            enemies |= defendingBishop;
-            break;
-        case Direction::SouthEast:
-            kingShift |= north_west(fKing);
-            rayMask = fPrimaryDiagonalAttacks[lsb];
-            enemies |= defendingBishop;
-            break;
-        case Direction::SouthWest:
-            kingShift |= north_east(fKing);
-            rayMask = fSecondaryDiagonalAttacks[lsb];
-            enemies |= defendingBishop;
-            break;
-        default:
-            return;
-            break;
-    }
-
-    rayOccupancy |= kingShift;
-    U64 ray = hypQuint(fKing, rayOccupancy, rayMask) ^ kingShift;
-    U64 rayAndEnemy = ray & enemies;
-
-    if(rayAndEnemy) { // Enemy piece on the ray pointing at the king (that could attack king, if not blocked)
-        // Note that rayAndEnemy is actually the position of the attacking piece on the ray
-        U64 potentialPin = ray & ownPieces; // All your pieces that exist on the ray (between king and attacking piece)
-        if(CountSetBits(potentialPin) == 1) { // A single piece is on the ray and so absolutely pinned
-            fPinnedPieces.push_back(std::make_pair(potentialPin, ray));
-        } // else : None of your pieces in the way so the king is in check from attacker
-    }
-}
-
-U64 Generator::GetPawnAttacks(const std::shared_ptr<Board> &board, bool colorToMoveAttacks) {
-    Color attackingColor = colorToMoveAttacks ? board->GetColorToMove() : (board->GetColorToMove() == Color::White ? Color::Black : Color::White);
-    U64 pawns = board->GetBoard(attackingColor, Piece::Pawn);
-    // Drop the absolutely pinned pawns for improved accuracy
-    pawns &= ~fPinnedPositions;
-    
-    if(attackingColor == Color::White) {
-        return north_east(pawns) | north_west(pawns);
-    } else {
-        return south_east(pawns) | south_west(pawns);
-    }
+template<Color C>
+bool Generator::GetEnPassantIsLegal(const std::shared_ptr<Board> &board, const AttackInfo &state, const U64 pawn, const U64 target) {
+    const U8 kingLSB = __builtin_ctzll(state.king);
+    const U64 enemyQueens = board->GetBoard(opposite(C), Piece::Queen);
+    const U64 occupancy = (state.occupancy ^ pawn ^ pawn_push<opposite(C)>(target)) | target;
+    return !(GetRookAttacks(kingLSB, occupancy) & (board->GetBoard(opposite(C), Piece::Rook) | enemyQueens)) &&
+        !(GetBishopAttacks(kingLSB, occupancy) & (board->GetBoard(opposite(C), Piece::Bishop) | enemyQueens));
 }
 
-void Generator::PruneCheckMoves(const std::shared_ptr<Board> &board, const bool copyToCapures) {
-    std::vector<U16> validMoves;
-    for (U16 move : (copyToCapures ? fCaptureMoves : fLegalMoves)) {
-        if (GetMoveIsCastling(move)) {
-            continue; // Skip castling moves
-        }
-        bool pieceIsKing = board->GetMovePiece(move) == Piece::King;
-        board->MakeMove(move);
-        U64 underAttack = GetAttacks(board, fColor == Color::White ? Color::Black : Color::White);
-        // King may have moved so can't use fActiveKing
-        U64 newKing = pieceIsKing ? board->GetBoard(fColor, Piece::King) : fKing;
-        if(!(underAttack & newKing)) {
-            validMoves.push_back(move); // Move is legal, add it to the vector
-        }
-        board->UndoMove();
-    }
-    // Replace fLegalMoves with validMoves
-    if(copyToCapures) {
-        fCaptureMoves = std::move(validMoves);
-    } else {
-        fLegalMoves = std::move(validMoves);
-    }
+U64 Generator::GetPawnAttacks(const std::shared_ptr<Board> &board, bool colorToMoveAttacks) const {
+    const Color attackingColor = colorToMoveAttacks ? board->GetColorToMove() : opposite(board->GetColorToMove());
+    const U64 pawns = board->GetBoard(attackingColor, Piece::Pawn);
+    return attackingColor == Color::White ? pawn_attacks<Color::White>(pawns) : pawn_attacks<Color::Black>(pawns);
 }
 
 bool Generator::GetMoveIsLegal(U16 &move) {
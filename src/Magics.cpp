@@ -0,0 +1,135 @@
+#include "Magics.hpp"
+
+Magic ROOK_MAGICS[NSQUARES];
+Magic BISHOP_MAGICS[NSQUARES];
+bool SLIDERS_USE_PEXT = false;
+
+namespace {
+
+U64 gRookTable[0x19000]; ///< Rook attacks for every square and relevant occupancy, 102400 entries in total.
+U64 gBishopTable[0x1480]; ///< Bishop attacks for every square and relevant occupancy, 5248 entries in total.
+
+constexpr int ROOK_STEPS[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}}; ///< (rank, file) steps of the rook rays.
+constexpr int BISHOP_STEPS[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}}; ///< (rank, file) steps of the bishop rays.
+
+/**
+ * @brief Walk the rays from a square one step at a time, used to build the tables.
+ * @param square The LSB of the sliding piece.
+ * @param occupancy The occupancy of the board, rays stop at the first occupied square.
+ * @param steps The four (rank, file) steps of the piece.
+ * @return Bitboard of attacked squares.
+*/
+U64 SlidingAttacks(const int square, const U64 occupancy, const int steps[4][2]) {
+    U64 attacks = 0;
+    for(int iRay = 0; iRay < 4; ++iRay) {
+        int rank = square / BITS_PER_FILE + steps[iRay][0];
+        int file = square % BITS_PER_FILE + steps[iRay][1];
+        while(rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+            const U64 bit = 1ULL << (rank * BITS_PER_FILE + file);
+            attacks |= bit;
+            if(occupancy & bit)
+                break;
+            rank += steps[iRay][0];
+            file += steps[iRay][1];
+        }
+    }
+    return attacks;
+}
+
+/**
+ * @brief Fixed-seed xorshift64* generator so the same magics are found on every run.
+*/
+class MagicRandom {
+    public:
+        explicit MagicRandom(U64 seed) : fState(seed) {};
+        U64 Next() {
+            fState ^= fState >> 12;
+            fState ^= fState << 25;
+            fState ^= fState >> 27;
+            return fState * 2685821657736338717ULL;
+        };
+        /**
+         * @brief Random number with roughly 1/8 of bits set, magics are usually sparse so these are found much faster.
+        */
+        U64 NextSparse() { return Next() & Next() & Next(); };
+    private:
+        U64 fState;
+};
+
+/**
+ * @brief Find a magic for every square and fill the matching attack table.
+ * @param magics The lookup entries to fill.
+ * @param table The attack table shared by all squares of this piece.
+ * @param steps The four (rank, file) steps of the piece.
+*/
+void FillMagics(Magic magics[NSQUARES], U64 *table, const int steps[4][2]) {
+    constexpr U64 seeds[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255}; // Per rank seeds that find magics quickly
+    U64 occupancies[4096];
+    U64 references[4096];
+    int epoch[4096] = {};
+    int attempt = 0;
+    U64 *attacks = table;
+
+    for(int square = 0; square < NSQUARES; ++square) {
+        // Edge squares never block a ray beyond them so are left out of the mask, unless the piece is on that edge
+        const U64 rank = get_rank(1ULL << square);
+        const U64 file = get_file(1ULL << square);
+        const U64 edges = ((RANK_1 | RANK_8) & ~rank) | ((FILE_A | FILE_H) & ~file);
+
+        Magic &m = magics[square];
+        m.mask = SlidingAttacks(square, 0, steps) & ~edges;
+        m.shift = NSQUARES - __builtin_popcountll(m.mask);
+        m.attacks = attacks;
+
+        // Enumerate every subset of the mask (Carry-Rippler) with its true attack set
+        int size = 0;
+        U64 subset = 0;
+        do {
+            occupancies[size] = subset;
+            references[size] = SlidingAttacks(square, subset, steps);
+            size++;
+            subset = (subset - m.mask) & m.mask;
+        } while(subset);
+
+        // PEXT maps every subset to a distinct index so no magic is needed
+        if(SLIDERS_USE_PEXT) {
+            for(int i = 0; i < size; ++i)
+                attacks[m.GetIndex(occupancies[i])] = references[i];
+            attacks += size;
+            continue;
+        }
+
+        // Try random magics until every subset maps onto an empty slot or one with the same attacks
+        MagicRandom random(seeds[square / BITS_PER_FILE]);
+        for(int i = 0; i < size; ) {
+            do {
+                m.magic = random.NextSparse();
+            } while(__builtin_popcountll((m.magic * m.mask) >> 56) < 6);
+
+            ++attempt;
+            for(i = 0; i < size; ++i) {
+                const unsigned int index = m.GetIndex(occupancies[i]);
+                if(epoch[index] < attempt) {
+                    epoch[index] = attempt;
+                    attacks[index] = references[i];
+                } else if(attacks[index] != references[i]) {
+                    break;
+                }
+            }
+        }
+        attacks += size;
+    }
+}
+
+} // namespace
+
+void InitMagics() {
+    static const bool initialised = [] {
+        DetectCpuFeatures();
+        SLIDERS_USE_PEXT = CPU_FEATURES.bmi2;
+        FillMagics(ROOK_MAGICS, gRookTable, ROOK_STEPS);
+        FillMagics(BISHOP_MAGICS, gBishopTable, BISHOP_STEPS);
+        return true;
+    }();
+    (void)initialised;
+}
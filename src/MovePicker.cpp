@@ -0,0 +1,114 @@
+#include "MovePicker.hpp"
+
+MovePicker::MovePicker(const std::shared_ptr<Generator> &generator, const std::shared_ptr<Board> &board, const AttackInfo &info, const U16 killers[2]) : 
+fGenerator(generator), fBoard(board), fInfo(info), fStage(info.checkers ? PickerStage::GenerateEvasions : PickerStage::GenerateCaptures), fKillers{killers[0], killers[1]}, fIndex(0), fNBadCaptures(0) {}
+
+int MovePicker::ScoreMove(const std::shared_ptr<Board> &board, const U16 move, const U64 enemyPawnAttacks) {
+    float scoreEstimate = 0.;
+    const int pieceType = (int)board->GetMovePiece(move);
+    const int takenPieceType = (int)board->GetMoveTakenPiece(move);
+
+    // Prioritise capturing opponent's most valuable pieces with our least valuable piece
+    if(takenPieceType != (int)Piece::Null)
+        scoreEstimate += 10. * PIECE_VALUES[takenPieceType] - PIECE_VALUES[pieceType];
+
+    // Promoting a pawn is probably a good plan
+    if(GetMoveIsPromotion(move))
+        scoreEstimate += PIECE_VALUES[(int)GetMovePromotionPiece(move)];
+
+    // Penalize moving our pieces to a square attacked by an opponent pawn
+    if(enemyPawnAttacks & GetMoveTarget(move))
+        scoreEstimate -= PIECE_VALUES[pieceType];
+
+    return (int)scoreEstimate;
+}
+
+void MovePicker::ScoreAndSort(MoveList &moves) {
+    for(int iMove = 0; iMove < moves.GetSize(); ++iMove)
+        moves.SetScore(iMove, ScoreMove(fBoard, moves[iMove], fInfo.enemyPawnAttacks));
+    moves.SortByScore(); // Higher scores come first
+}
+
+void MovePicker::ScoreAndSortQuiets() {
+    // Checks are worked out from the check squares once for the node, without making any of the moves
+    CheckInfo checkInfo;
+    fGenerator->UpdateCheckInfo(fBoard, fInfo, checkInfo);
+    for(int iMove = 0; iMove < fQuiets.GetSize(); ++iMove) {
+        int score = ScoreMove(fBoard, fQuiets[iMove], fInfo.enemyPawnAttacks);
+        if(fGenerator->GivesCheck(fBoard, checkInfo, fQuiets[iMove]))
+            score += QUIET_CHECK_BONUS;
+        fQuiets.SetScore(iMove, score);
+    }
+    fQuiets.SortByScore();
+}
+
+U16 MovePicker::GetNextMove() {
+    switch(fStage) {
+        case PickerStage::GenerateEvasions:
+            fGenerator->GenerateEvasionMoves(fBoard, fInfo, fCaptures);
+            ScoreAndSort(fCaptures);
+            fIndex = 0;
+            fStage = PickerStage::Evasions;
+            [[fallthrough]];
+        case PickerStage::Evasions:
+            if(fIndex < fCaptures.GetSize())
+                return fCaptures[fIndex++];
+            fStage = PickerStage::Done;
+            return 0;
+        case PickerStage::GenerateCaptures:
+            fGenerator->GenerateCaptureMoves(fBoard, fInfo, fCaptures);
+            ScoreAndSort(fCaptures);
+            fIndex = 0;
+            fStage = PickerStage::GoodCaptures;
+            [[fallthrough]];
+        case PickerStage::GoodCaptures:
+            while(fIndex < fCaptures.GetSize()) {
+                const U16 move = fCaptures[fIndex++];
+                // Taking a piece worth at least the capturer can't lose material, only cheaper victims need the full exchange
+                // worked out. En-passant lands on an empty square so counts as taking nothing, it trades pawns and is kept as good
+                const Piece taken = fBoard->GetMoveTakenPiece(move);
+                if(taken != Piece::Null && PIECE_VALUES[(int)taken] < PIECE_VALUES[(int)fBoard->GetMovePiece(move)] &&
+                    fGenerator->GetStaticExchange(fBoard, move) < 0) {
+                    fCaptures.SetMove(fNBadCaptures++, move); // Already handed out moves are free to overwrite
+                    continue;
+                }
+                return move;
+            }
+            fStage = PickerStage::Killers;
+            fIndex = 0;
+            [[fallthrough]];
+        case PickerStage::Killers:
+            // Killers come from sibling positions, only play them if they are legal quiet moves here. Checking them directly
+            // means a killer cut off never generates the quiet moves. A drawn position has no moves at all
+            while(fIndex < 2) {
+                const U16 killer = fKillers[fIndex++];
+                if(killer && !GetMoveIsCapture(killer) && fBoard->GetState() == State::Play &&
+                    fGenerator->IsPseudoLegal(fBoard, fInfo, killer) && fGenerator->IsLegal(fBoard, fInfo, killer))
+                    return killer;
+                fKillers[fIndex - 1] = 0; // Not played, so nothing to leave out of the quiet moves
+            }
+            fStage = PickerStage::GenerateQuiets;
+            [[fallthrough]];
+        case PickerStage::GenerateQuiets:
+            fGenerator->GenerateQuietMoves(fBoard, fInfo, fQuiets);
+            fQuiets.RemoveIf([this](const U16 move) { return move == fKillers[0] || move == fKillers[1]; });
+            ScoreAndSortQuiets();
+            fStage = PickerStage::Quiets;
+            fIndex = 0;
+            [[fallthrough]];
+        case PickerStage::Quiets:
+            if(fIndex < fQuiets.GetSize())
+                return fQuiets[fIndex++];
+            fStage = PickerStage::BadCaptures;
+            fIndex = 0;
+            [[fallthrough]];
+        case PickerStage::BadCaptures:
+            if(fIndex < fNBadCaptures)
+                return fCaptures[fIndex++];
+            fStage = PickerStage::Done;
+            [[fallthrough]];
+        case PickerStage::Done:
+        default:
+            return 0;
+    }
+}
@@ -162,7 +162,6 @@ void Renderer::gameLoopSlot() {
 
                 // Make the move
                 fBoard->MakeMove(move);
-                fBoard->AddCurrentHistory();
 
                 // Update the GUI accordingly
                 DrawPieces();
@@ -303,8 +302,8 @@ void Renderer::HighlightLegalMoves() {
     fHighlighted.clear();
     std::vector<U64> legalEndTiles{};
 
-    std::vector<U16> legalMoves = fGenerator->GetLegalMoves();
-    for(std::size_t iMove = 0; iMove < legalMoves.size(); ++iMove) {
+    const MoveList &legalMoves = fGenerator->GetLegalMoves();
+    for(int iMove = 0; iMove < legalMoves.GetSize(); ++iMove) {
         if(GetMoveOrigin(legalMoves[iMove]) & fStartSquare) {
             legalEndTiles.push_back(GetMoveTarget(legalMoves[iMove]));
         }
@@ -347,7 +346,6 @@ void Renderer::mouseReleaseEvent(QMouseEvent *event) {
     bool isLegal = fGenerator->GetMoveIsLegal(move);
     if(isLegal) {
         fBoard->MakeMove(move);
-        fBoard->AddCurrentHistory();
     }
     
     DrawPieces();
@@ -402,7 +400,6 @@ void Renderer::UpdateMakeMove() {
     bool isLegal = fGenerator->GetMoveIsLegal(move);
     if(isLegal) {
         fBoard->MakeMove(move);
-        fBoard->AddCurrentHistory();
     }
     DrawPieces();
 }
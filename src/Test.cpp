@@ -5,6 +5,7 @@ Test::Test(bool useGUI) {
     fGenerator = std::make_unique<Generator>();
     fUseGUI = useGUI;
     fDoFinePrint = false;
+    fBulkCounting = true;
     //if(fUseGUI)
     //    fGUI = std::make_unique<Renderer>();
     fPrintDepth = 999;
@@ -21,6 +22,14 @@ Test::Test(bool useGUI) {
         84998978956,
         2439530234167,
     };
+
+    fBenchmarkPositions = {
+        "",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    };
 }
 
 unsigned long int Test::GetNodes(int depth, std::string fen, bool doFinePrint) {
@@ -40,17 +49,18 @@ unsigned long int Test::MoveGeneration(int depth) {
     if(depth == 0)
         return 1;
 
-    fGenerator->GenerateLegalMoves(fBoard);
+    MoveList moves;
+    fGenerator->GenerateLegalMoves(fBoard, moves); // Puts moves inside this list for you
     unsigned long int numPositions = 0;
     unsigned long int subPositions = 0;
 
-    std::vector<U16> moves = fGenerator->GetLegalMoves(); // Puts moves inside this vector for you
-
     if(depth == fPrintDepth)
-        std::cout << "Parent nodes searched: " << moves.size() << "\n";
+        std::cout << "Parent nodes searched: " << moves.GetSize() << "\n";
+    else if(depth == 1 && fBulkCounting && !fDoFinePrint)
+        return moves.GetSize(); // Every legal move leads to exactly one leaf, no need to make them
 
-    for(std::size_t iMove = 0; iMove < moves.size(); iMove++) {
-        U16 move = moves.at(iMove);
+    for(int iMove = 0; iMove < moves.GetSize(); iMove++) {
+        U16 move = moves[iMove];
         if(depth == fPrintDepth) {
             PrintMove(move); 
             subPositions = numPositions;
@@ -68,4 +78,54 @@ unsigned long int Test::MoveGeneration(int depth) {
     }
 
     return numPositions;
+}
+
+void Test::Benchmark(int perftDepth, int searchDepth) {
+    const std::shared_ptr<Engine> engine = std::make_unique<Engine>(fGenerator, fBoard, searchDepth);
+    unsigned long int totalPerftNodes = 0;
+    unsigned long int totalSearchNodes = 0;
+    double totalPerftSeconds = 0.;
+    double totalSearchSeconds = 0.;
+    unsigned long int totalCopyMakeNodes = 0;
+    double totalCopyMakeSeconds = 0.;
+    SetPrintDepth(-1); // Don't print the per-move breakdown
+    SetBulkCounting(false); // Perft nps measures make/unmake of every leaf as well as generation, comparable across versions
+
+    for(const std::string &fen : fBenchmarkPositions) {
+        fen.length() > 0 ? fBoard->LoadFEN(fen) : fBoard->Reset();
+        auto start = std::chrono::high_resolution_clock::now();
+        const unsigned long int perftNodes = MoveGeneration(perftDepth);
+        const double perftSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        engine->SetDifficulty(3000); // Enables every evaluation term and clears the evaluation cache
+        start = std::chrono::high_resolution_clock::now();
+        engine->GetBestMove(false);
+        const double searchSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        const unsigned long int searchNodes = engine->GetNMovesSearched();
+
+        // Same search again taking moves back by restoring snapshots instead of UndoMove
+        engine->SetDifficulty(3000);
+        engine->SetCopyMake(true);
+        start = std::chrono::high_resolution_clock::now();
+        engine->GetBestMove(false);
+        const double copyMakeSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        const unsigned long int copyMakeNodes = engine->GetNMovesSearched();
+        engine->SetCopyMake(false);
+
+        std::cout << (fen.length() > 0 ? fen : "startpos") << "\n";
+        std::cout << "  perft(" << perftDepth << ") nodes " << perftNodes << " nps " << (unsigned long int)(perftNodes / perftSeconds) << "\n";
+        std::cout << "  search(" << searchDepth << ") nodes " << searchNodes << " nps " << (unsigned long int)(searchNodes / searchSeconds) << "\n";
+        std::cout << "  search(" << searchDepth << ") copy-make nodes " << copyMakeNodes << " nps " << (unsigned long int)(copyMakeNodes / copyMakeSeconds) << "\n";
+        totalPerftNodes += perftNodes;
+        totalPerftSeconds += perftSeconds;
+        totalSearchNodes += searchNodes;
+        totalSearchSeconds += searchSeconds;
+        totalCopyMakeNodes += copyMakeNodes;
+        totalCopyMakeSeconds += copyMakeSeconds;
+    }
+
+    std::cout << "\n========== Benchmark ==========\n";
+    std::cout << "Perft nodes:  " << totalPerftNodes << " nps " << (unsigned long int)(totalPerftNodes / totalPerftSeconds) << "\n";
+    std::cout << "Search nodes: " << totalSearchNodes << " nps " << (unsigned long int)(totalSearchNodes / totalSearchSeconds) << "\n";
+    std::cout << "Copy-make search nodes: " << totalCopyMakeNodes << " nps " << (unsigned long int)(totalCopyMakeNodes / totalCopyMakeSeconds) << "\n";
 }
\ No newline at end of file